@@ -0,0 +1,99 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// BenchUtil.cpp
+//
+// Helpers the benchmarks share.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include "BenchUtil.h"
+
+using namespace std;
+namespace po = boost::program_options;
+
+/**
+ * Runs a piece of work once.
+ * @param work The work.
+ * @return How long it took, in seconds.
+ */
+double timeOnce(const function<void()>& work){
+    auto start = chrono::steady_clock::now();
+    work();
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Reads the command line. Bad options print the help, and --help
+ * prints it and stops.
+ * @param argc The number of arguments.
+ * @param argv The arguments.
+ * @param desc The options, which should include --help.
+ * @param vm Receives the values.
+ * @param status Receives what main should return if it stops.
+ * @return Boolean indicating whether to carry on.
+ */
+bool parseOptions(int argc, const char** argv, const po::options_description& desc, po::variables_map& vm,
+                  int& status){
+    try {
+        po::store(po::parse_command_line(argc, argv, desc), vm);
+        po::notify(vm);
+    } catch (po::error& e){
+        cerr << "Error: " << e.what() << endl << desc << endl;
+        status = 1;
+        return false;
+    }
+    if (vm.count("help")){
+        cout << desc << endl;
+        status = 0;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Formats a number for a result line. CSV keeps full precision and
+ * tables show two decimals.
+ * @param value The number.
+ * @param csv Whether the line is CSV.
+ * @return The text.
+ */
+string formatNumber(double value, bool csv){
+    ostringstream out;
+    if (!csv) out << fixed << setprecision(2);
+    out << value;
+    return out.str();
+}
+
+/**
+ * Prints one line of results or headings. In a table the first cell
+ * is left aligned and the rest are right aligned to their widths.
+ * @param cells The cells.
+ * @param widths The width of each cell in a table.
+ * @param csv Whether to print CSV instead of a table.
+ */
+void printRow(const vector<string>& cells, const vector<int>& widths, bool csv){
+    for (int i = 0; i < cells.size(); i++){
+        if (csv){
+            cout << ((i > 0) ? "," : "") << cells[i];
+        } else {
+            int width = (i < widths.size()) ? widths[i] : 0;
+            cout << ((i == 0) ? left : right) << setw(width) << cells[i];
+        }
+    }
+    cout << right << endl;
+}
@@ -0,0 +1,41 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// BenchUtil.h
+//
+// Helpers the benchmarks share: timing a piece of work,
+// reading the command line and printing results either
+// as an aligned table or as CSV.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef ZELDA_BENCHUTIL_H
+#define ZELDA_BENCHUTIL_H
+
+#include <functional>
+#include <string>
+#include <vector>
+#include <boost/program_options.hpp>
+
+//Timing
+double timeOnce(const std::function<void()>& work);
+
+//Options
+bool parseOptions(int argc, const char** argv, const boost::program_options::options_description& desc,
+                  boost::program_options::variables_map& vm, int& status);
+
+//Output
+std::string formatNumber(double value, bool csv);
+void printRow(const std::vector<std::string>& cells, const std::vector<int>& widths, bool csv);
+
+#endif //ZELDA_BENCHUTIL_H
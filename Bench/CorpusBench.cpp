@@ -0,0 +1,357 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// CorpusBench.cpp
+//
+// Runs Zelda over generated corpora of growing size and
+// reports units per second, nodes per second and peak
+// memory at each size, so costs that grow faster than the
+// corpus show up before they reach real projects. Can
+// also run one corpus at a growing number of workers to
+// report speedup, lock waits and memory per worker, or
+// just write a corpus.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <boost/filesystem.hpp>
+#include <boost/program_options.hpp>
+#include "BenchUtil.h"
+#include "CorpusGenerator.h"
+#include "../JSON/json.h"
+
+using namespace std;
+using namespace boost::filesystem;
+namespace po = boost::program_options;
+
+/** Where Zelda writes its output inside the corpus, and the stats file in it. */
+static const string OUTPUT_DIRNAME = "ZeldaAnalysis";
+static const string STATS_FILENAME = "stats.json";
+
+/** What one run of Zelda measured. */
+struct Run {
+    bool success = false;
+    double seconds = 0;
+    double cpuSeconds = 0;
+    double waitSeconds = 0;             //Time threads spent waiting on the locks of shared tables.
+    long peakRSSKB = 0;
+    long nodes = 0;
+};
+
+/**
+ * Splits a comma separated list of numbers.
+ * @param list The list.
+ * @param numbers Receives the numbers.
+ * @return Boolean indicating whether every entry was a positive number.
+ */
+static bool parseSizes(const string& list, vector<int>& numbers){
+    stringstream stream(list);
+    string entry;
+    while (getline(stream, entry, ',')){
+        try {
+            int number = stoi(entry);
+            if (number <= 0) return false;
+            numbers.push_back(number);
+        } catch (exception&){
+            return false;
+        }
+    }
+    return !numbers.empty();
+}
+
+/**
+ * Runs Zelda on a corpus with its output silenced, and waits for it.
+ * The peak memory comes from the kernel, so it is known even if
+ * Zelda fails before writing its stats.
+ * @param zelda The Zelda executable.
+ * @param corpus The corpus directory.
+ * @param extra Additional arguments for Zelda.
+ * @return What was measured.
+ */
+static Run runZelda(const string& zelda, const string& corpus, const vector<string>& extra){
+    vector<string> args = {zelda, "--stats", "--slowest", "0"};
+    args.insert(args.end(), extra.begin(), extra.end());
+    args.push_back(corpus);
+    vector<char*> argv;
+    for (auto& arg : args) argv.push_back(const_cast<char*>(arg.c_str()));
+    argv.push_back(nullptr);
+
+    //Earlier runs would otherwise move the output and feed their timings to the scheduler.
+    Run run;
+    remove_all(corpus + "/" + OUTPUT_DIRNAME);
+    auto start = chrono::steady_clock::now();
+    pid_t child = fork();
+    if (child < 0) return run;
+    if (child == 0){
+        int null = open("/dev/null", O_WRONLY);
+        if (null >= 0){
+            dup2(null, STDOUT_FILENO);
+            dup2(null, STDERR_FILENO);
+        }
+        execvp(argv[0], argv.data());
+        _exit(127);
+    }
+
+    int status = 0;
+    rusage usage;
+    if (wait4(child, &status, 0, &usage) < 0) return run;
+    run.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    run.peakRSSKB = usage.ru_maxrss;
+    run.success = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+
+    //Counts the nodes of the merged graph from the memory breakdown.
+    std::ifstream in(corpus + "/" + OUTPUT_DIRNAME + "/" + STATS_FILENAME, std::ifstream::binary);
+    if (!in.is_open()) return run;
+    Json::Value stats;
+    try {
+        in >> stats;
+    } catch (Json::Exception& e){
+        return run;
+    }
+    run.cpuSeconds = stats.get("cpuSeconds", 0).asDouble();
+    for (auto& site : stats["lockWaits"]) run.waitSeconds += site.get("waitSeconds", 0).asDouble();
+    const Json::Value& nodes = stats["graphMemory"]["nodes"];
+    if (!nodes.isObject()) return run;
+    for (auto& name : nodes.getMemberNames()) run.nodes += nodes[name]["count"].asInt64();
+    return run;
+}
+
+/**
+ * Runs Zelda several times and keeps the fastest run, which is the
+ * one least disturbed by the rest of the machine.
+ * @param zelda The Zelda executable.
+ * @param corpus The corpus directory.
+ * @param extra Additional arguments for Zelda.
+ * @param runs How many times to run.
+ * @return The fastest successful run, or a failed one if none succeeded.
+ */
+static Run bestRun(const string& zelda, const string& corpus, const vector<string>& extra, int runs){
+    Run best;
+    for (int i = 0; i < runs; i++){
+        Run run = runZelda(zelda, corpus, extra);
+        if (run.success && (!best.success || run.seconds < best.seconds)) best = run;
+    }
+    return best;
+}
+
+/**
+ * Runs Zelda over a fresh corpus of each size.
+ * @param settings The shape of the corpora.
+ * @param sizes The numbers of units.
+ * @param zelda The Zelda executable.
+ * @param dir Where the corpora are written.
+ * @param extra Additional arguments for Zelda.
+ * @param runs How many times to run each size.
+ * @param keep Whether to keep each corpus.
+ * @param csv Whether to print CSV instead of a table.
+ * @return Boolean indicating whether every size ran.
+ */
+static bool scaleUnits(CorpusGenerator::Settings settings, const vector<int>& sizes, const string& zelda,
+                       const string& dir, const vector<string>& extra, int runs, bool keep, bool csv){
+    vector<int> widths = {8, 12, 12, 12, 14, 12, 10};
+    if (csv){
+        printRow({"units", "seconds", "unitsPerSecond", "nodes", "nodesPerSecond", "peakRSSKB", "scaling"}, widths, csv);
+    } else {
+        printRow({"units", "seconds", "units/s", "nodes", "nodes/s", "peak MB", "scaling"}, widths, csv);
+    }
+
+    //Scaling is the time per unit relative to the previous size; above one means superlinear.
+    double previousPerUnit = 0;
+    bool success = true;
+    for (int size : sizes){
+        settings.units = size;
+        string corpus = dir + "/units" + to_string(size);
+        remove_all(corpus);
+        string error;
+        if (!CorpusGenerator(settings).write(corpus, error)){
+            cerr << "Error: " << error << endl;
+            return false;
+        }
+
+        Run run = bestRun(zelda, absolute(corpus).string(), extra, runs);
+        if (!keep) remove_all(corpus);
+        if (!run.success){
+            cerr << "Error: Zelda failed on " << size << " units." << endl;
+            success = false;
+            continue;
+        }
+
+        double perUnit = run.seconds / size;
+        double scaling = (previousPerUnit > 0) ? perUnit / previousPerUnit : 1;
+        previousPerUnit = perUnit;
+        string peak = (csv) ? to_string(run.peakRSSKB) : formatNumber(run.peakRSSKB / 1024.0, csv);
+        printRow({to_string(size), formatNumber(run.seconds, csv), formatNumber(size / run.seconds, csv),
+                  to_string(run.nodes), formatNumber(run.nodes / run.seconds, csv), peak, formatNumber(scaling, csv)},
+                 widths, csv);
+    }
+    return success;
+}
+
+/**
+ * Runs Zelda over one corpus with 1, 2, 4 and so on up to the given
+ * number of workers. Speedup and efficiency are against one worker.
+ * The wait share is the lock wait over the worker time available,
+ * and memory per worker is how much each worker past the first adds
+ * to the peak.
+ * @param settings The shape of the corpus.
+ * @param units The number of units.
+ * @param workers The largest number of workers.
+ * @param zelda The Zelda executable.
+ * @param dir Where the corpus is written.
+ * @param extra Additional arguments for Zelda.
+ * @param runs How many times to run each worker count.
+ * @param keep Whether to keep the corpus.
+ * @param csv Whether to print CSV instead of a table.
+ * @return Boolean indicating whether every worker count ran.
+ */
+static bool scaleWorkers(CorpusGenerator::Settings settings, int units, int workers, const string& zelda,
+                         const string& dir, const vector<string>& extra, int runs, bool keep, bool csv){
+    settings.units = units;
+    string corpus = dir + "/units" + to_string(units);
+    remove_all(corpus);
+    string error;
+    if (!CorpusGenerator(settings).write(corpus, error)){
+        cerr << "Error: " << error << endl;
+        return false;
+    }
+
+    vector<int> counts;
+    for (int count = 1; count < workers; count *= 2) counts.push_back(count);
+    counts.push_back(workers);
+
+    vector<int> widths = {8, 12, 10, 12, 10, 10, 8, 10, 12};
+    if (csv){
+        printRow({"workers", "seconds", "speedup", "efficiency", "cpuSeconds", "waitSeconds", "waitShare", "peakRSSKB",
+                  "kbPerWorker"}, widths, csv);
+    } else {
+        printRow({"workers", "seconds", "speedup", "efficiency", "cpu s", "wait s", "wait%", "peak MB", "MB/worker"},
+                 widths, csv);
+    }
+
+    Run base;
+    bool success = true;
+    for (int count : counts){
+        vector<string> args = extra;
+        args.push_back("--jobs");
+        args.push_back(to_string(count));
+        Run run = bestRun(zelda, absolute(corpus).string(), args, runs);
+        if (!run.success){
+            cerr << "Error: Zelda failed with " << count << " workers." << endl;
+            success = false;
+            continue;
+        }
+        if (count == 1) base = run;
+
+        double speedup = (base.success) ? base.seconds / run.seconds : 0;
+        double efficiency = speedup / count;
+        double waitShare = run.waitSeconds / (run.seconds * count);
+        double perWorker = (base.success && count > 1) ? double(run.peakRSSKB - base.peakRSSKB) / (count - 1) : 0;
+        //Tables show the wait share as a percentage and memory in megabytes; CSV keeps the raw values.
+        double unit = (csv) ? 1 : 1024.0;
+        string peak = (csv) ? to_string(run.peakRSSKB) : formatNumber(run.peakRSSKB / unit, csv);
+        printRow({to_string(count), formatNumber(run.seconds, csv), formatNumber(speedup, csv),
+                  formatNumber(efficiency, csv), formatNumber(run.cpuSeconds, csv), formatNumber(run.waitSeconds, csv),
+                  formatNumber((csv) ? waitShare : waitShare * 100, csv), peak, formatNumber(perWorker / unit, csv)},
+                 widths, csv);
+    }
+    if (!keep) remove_all(corpus);
+    return success;
+}
+
+int main(int argc, const char** argv){
+    CorpusGenerator::Settings settings;
+    po::options_description desc("Options");
+    desc.add_options()
+            ("help,h", "Prints this help message.")
+            ("zelda", po::value<string>()->default_value("Zelda"), "The Zelda executable.")
+            ("sizes", po::value<string>()->default_value("10,100,1000"), "Comma separated numbers of units to run.")
+            ("dir", po::value<string>()->default_value("ZeldaCorpus"), "Where the corpora are written.")
+            ("generate", "Only writes a corpus of the first size, without running Zelda.")
+            ("workers", po::value<int>(), "Runs a corpus of the first size at 1, 2, 4 and so on up to this many workers.")
+            ("runs", po::value<int>()->default_value(1), "Runs per measurement; the fastest is kept.")
+            ("keep", "Keeps each corpus after it is run.")
+            ("args", po::value<string>()->default_value(""), "Additional arguments for Zelda, space separated.")
+            ("functions", po::value<int>(&settings.functions)->default_value(settings.functions), "Functions per unit.")
+            ("depth", po::value<int>(&settings.depth)->default_value(settings.depth), "Layers of the call graph.")
+            ("fanout", po::value<int>(&settings.fanOut)->default_value(settings.fanOut), "Calls per function.")
+            ("hierarchy-depth", po::value<int>(&settings.hierarchyDepth)->default_value(settings.hierarchyDepth),
+             "Levels of exception classes.")
+            ("hierarchy-width", po::value<int>(&settings.hierarchyWidth)->default_value(settings.hierarchyWidth),
+             "Subclasses of each exception class.")
+            ("try-depth", po::value<int>(&settings.tryDepth)->default_value(settings.tryDepth),
+             "Largest nesting of try blocks.")
+            ("throw-rate", po::value<double>(&settings.throwRate)->default_value(settings.throwRate),
+             "Chance a function throws.")
+            ("rethrow-rate", po::value<double>(&settings.rethrowRate)->default_value(settings.rethrowRate),
+             "Chance a handler rethrows.")
+            ("headers", po::value<int>(&settings.sharedHeaders)->default_value(settings.sharedHeaders),
+             "Number of shared headers.")
+            ("headers-per-unit", po::value<int>(&settings.headersPerUnit)->default_value(settings.headersPerUnit),
+             "Shared headers each unit includes.")
+            ("seed", po::value<unsigned int>(&settings.seed)->default_value(settings.seed), "Random seed.")
+            ("csv", "Prints CSV instead of a table.");
+
+    po::variables_map vm;
+    int status;
+    if (!parseOptions(argc, argv, desc, vm, status)) return status;
+
+    vector<int> sizes;
+    if (!parseSizes(vm["sizes"].as<string>(), sizes)){
+        cerr << "Error: --sizes must be a list of positive numbers." << endl;
+        return 1;
+    }
+    if (settings.functions < 1 || settings.depth < 1){
+        cerr << "Error: --functions and --depth must be at least one." << endl;
+        return 1;
+    }
+    vector<string> extra;
+    istringstream argStream(vm["args"].as<string>());
+    for (string arg; argStream >> arg;) extra.push_back(arg);
+    string dir = vm["dir"].as<string>();
+    bool csv = vm.count("csv") > 0;
+
+    if (vm.count("generate")){
+        settings.units = sizes[0];
+        string error;
+        if (!CorpusGenerator(settings).write(dir, error)){
+            cerr << "Error: " << error << endl;
+            return 1;
+        }
+        cout << "Wrote " << settings.units << " units to " << dir << "." << endl;
+        return 0;
+    }
+
+    string zelda = vm["zelda"].as<string>();
+    int runs = vm["runs"].as<int>();
+    bool keep = vm.count("keep") > 0;
+    if (runs < 1){
+        cerr << "Error: --runs must be at least one." << endl;
+        return 1;
+    }
+    if (vm.count("workers")){
+        int workers = vm["workers"].as<int>();
+        if (workers < 1){
+            cerr << "Error: --workers must be at least one." << endl;
+            return 1;
+        }
+        return scaleWorkers(settings, sizes[0], workers, zelda, dir, extra, runs, keep, csv) ? 0 : 1;
+    }
+    return scaleUnits(settings, sizes, zelda, dir, extra, runs, keep, csv) ? 0 : 1;
+}
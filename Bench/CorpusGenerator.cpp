@@ -0,0 +1,287 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// CorpusGenerator.cpp
+//
+// Writes a synthetic C++ project for end-to-end scaling runs.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <set>
+#include <sstream>
+#include <boost/filesystem.hpp>
+#include "CorpusGenerator.h"
+
+using namespace std;
+using namespace boost::filesystem;
+
+/**
+ * Creates a generator. The same settings always write the same corpus.
+ * @param settings The shape of the corpus.
+ */
+CorpusGenerator::CorpusGenerator(const Settings& settings) : settings(settings), random(settings.seed) {
+    //Lays the exception classes out breadth first, so parents come before their children.
+    exceptionParents.push_back(-1);
+    int levelStart = 0;
+    for (int level = 0; level < settings.hierarchyDepth; level++){
+        int levelEnd = (int) exceptionParents.size();
+        for (int parent = levelStart; parent < levelEnd; parent++){
+            for (int i = 0; i < settings.hierarchyWidth; i++) exceptionParents.push_back(parent);
+        }
+        levelStart = levelEnd;
+    }
+}
+
+/**
+ * Writes the corpus. Headers go in include/, units in src/ and
+ * compile_commands.json in the directory itself.
+ * @param directory The directory to write to. It is created if needed.
+ * @param error Receives the reason if writing fails.
+ * @return Boolean indicating success.
+ */
+bool CorpusGenerator::write(const string& directory, string& error){
+    path root = absolute(path(directory));
+    boost::system::error_code code;
+    create_directories(root / "include", code);
+    if (!code) create_directories(root / "src", code);
+    if (code){
+        error = "Could not create " + root.string() + ": " + code.message();
+        return false;
+    }
+
+    //Opens a file, runs a writer on it and checks the result.
+    auto emit = [&](const path& file, const function<void(ostream&)>& writer) -> bool {
+        std::ofstream out(file.string());
+        if (!out.is_open()){
+            error = "Could not write " + file.string();
+            return false;
+        }
+        writer(out);
+        if (!out.good()) error = "Could not write " + file.string();
+        return out.good();
+    };
+
+    if (!emit(root / "include" / "errors.h", [&](ostream& out){ writeExceptions(out); })) return false;
+    for (int i = 0; i < settings.sharedHeaders; i++){
+        path file = root / "include" / ("shared" + to_string(i) + ".h");
+        if (!emit(file, [&](ostream& out){ writeSharedHeader(out, i); })) return false;
+    }
+    for (int i = 0; i < settings.units; i++){
+        path header = root / "include" / ("unit" + to_string(i) + ".h");
+        if (!emit(header, [&](ostream& out){ writeUnitHeader(out, i); })) return false;
+        path unit = root / "src" / ("unit" + to_string(i) + ".cpp");
+        if (!emit(unit, [&](ostream& out){ writeUnit(out, i); })) return false;
+    }
+    return emit(root / "compile_commands.json", [&](ostream& out){ writeCompileCommands(out, root.string()); });
+}
+
+/**
+ * Gets the number of exception classes, the root included.
+ * @return The number of classes.
+ */
+int CorpusGenerator::getNumExceptions(){
+    return (int) exceptionParents.size();
+}
+
+/**
+ * Picks a number uniformly.
+ * @param count The number of choices.
+ * @return The number, below count.
+ */
+int CorpusGenerator::pick(int count){
+    uniform_int_distribution<int> choice(0, count - 1);
+    return choice(random);
+}
+
+/**
+ * Flips a biased coin.
+ * @param probability The chance of true.
+ * @return The outcome.
+ */
+bool CorpusGenerator::chance(double probability){
+    uniform_real_distribution<double> choice(0, 1);
+    return choice(random) < probability;
+}
+
+/**
+ * Gets the units in one layer of the call graph. Unit i sits in layer i % depth.
+ * @param layer The layer.
+ * @return The units, empty past the last layer.
+ */
+vector<int> CorpusGenerator::unitsInLayer(int layer){
+    vector<int> units;
+    if (layer >= settings.depth) return units;
+    for (int i = layer; i < settings.units; i += settings.depth) units.push_back(i);
+    return units;
+}
+
+/**
+ * Gets the name of an exception class.
+ * @param index The class number. Zero is the root.
+ * @return The qualified name.
+ */
+string CorpusGenerator::exceptionName(int index){
+    return "errors::Error" + to_string(index);
+}
+
+/**
+ * Writes the exception hierarchy. The root derives from std::exception.
+ * @param out The stream to write to.
+ */
+void CorpusGenerator::writeExceptions(ostream& out){
+    out << "#ifndef CORPUS_ERRORS_H\n#define CORPUS_ERRORS_H\n\n#include <exception>\n\nnamespace errors {\n\n";
+    out << "class Error0 : public std::exception {\npublic:\n"
+        << "    explicit Error0(const char* where) : where(where) {}\n"
+        << "    const char* what() const noexcept override { return where; }\n"
+        << "private:\n    const char* where;\n};\n\n";
+    for (int i = 1; i < exceptionParents.size(); i++){
+        out << "class Error" << i << " : public Error" << exceptionParents[i] << " {\npublic:\n"
+            << "    explicit Error" << i << "(const char* where) : Error" << exceptionParents[i] << "(where) {}\n};\n\n";
+    }
+    out << "} //namespace errors\n\n#endif\n";
+}
+
+/**
+ * Writes a shared header of small inline functions, some of which throw.
+ * @param out The stream to write to.
+ * @param header The header number.
+ */
+void CorpusGenerator::writeSharedHeader(ostream& out, int header){
+    out << "#ifndef CORPUS_SHARED" << header << "_H\n#define CORPUS_SHARED" << header << "_H\n\n"
+        << "#include \"errors.h\"\n\nnamespace shared" << header << " {\n\n";
+    for (int i = 0; i < settings.headerFunctions; i++){
+        out << "inline int helper" << i << "(int value){\n";
+        if (chance(settings.throwRate)){
+            out << "    if (value < 0) throw " << exceptionName(pick(getNumExceptions()))
+                << "(\"shared" << header << "::helper" << i << "\");\n";
+        }
+        out << "    return value * " << i + 2 << ";\n}\n\n";
+    }
+    out << "} //namespace shared" << header << "\n\n#endif\n";
+}
+
+/**
+ * Writes the header declaring a unit's functions.
+ * @param out The stream to write to.
+ * @param unit The unit number.
+ */
+void CorpusGenerator::writeUnitHeader(ostream& out, int unit){
+    out << "#ifndef CORPUS_UNIT" << unit << "_H\n#define CORPUS_UNIT" << unit << "_H\n\n"
+        << "namespace unit" << unit << " {\n\n";
+    for (int i = 0; i < settings.functions; i++) out << "int function" << i << "(int value);\n";
+    out << "\n} //namespace unit" << unit << "\n\n#endif\n";
+}
+
+/**
+ * Writes a unit. Its functions call functions of units in the next
+ * layer, so the call graph is as deep as the number of layers.
+ * @param out The stream to write to.
+ * @param unit The unit number.
+ */
+void CorpusGenerator::writeUnit(ostream& out, int unit){
+    set<int> headers;
+    for (int i = 0; i < min(settings.headersPerUnit, settings.sharedHeaders); i++){
+        headers.insert(pick(settings.sharedHeaders));
+    }
+
+    //Bodies are written first so only the callees' headers are included.
+    ostringstream bodies;
+    set<int> callees;
+    vector<int> next = unitsInLayer(unit % settings.depth + 1);
+    for (int i = 0; i < settings.functions; i++){
+        bodies << "int function" << i << "(int value){\n";
+        if (chance(settings.throwRate)){
+            bodies << "    if (value > " << pick(100) << ") throw " << exceptionName(pick(getNumExceptions()))
+                   << "(\"unit" << unit << "::function" << i << "\");\n";
+        }
+
+        //Builds the calls, then wraps them in try blocks from the inside out.
+        ostringstream calls;
+        for (int j = 0; j < settings.fanOut && !next.empty(); j++){
+            int callee = next[pick((int) next.size())];
+            callees.insert(callee);
+            calls << "value += unit" << callee << "::function" << pick(settings.functions) << "(value - 1);\n";
+        }
+        if (!headers.empty()){
+            auto header = headers.begin();
+            advance(header, pick((int) headers.size()));
+            calls << "value += shared" << *header << "::helper" << pick(settings.headerFunctions) << "(value);\n";
+        }
+        writeBody(bodies, unit, i, (settings.tryDepth > 0) ? 1 + pick(settings.tryDepth) : 0, calls.str());
+        bodies << "    return value;\n}\n\n";
+    }
+
+    out << "#include \"errors.h\"\n";
+    for (int header : headers) out << "#include \"shared" << header << ".h\"\n";
+    out << "#include \"unit" << unit << ".h\"\n";
+    for (int callee : callees) out << "#include \"unit" << callee << ".h\"\n";
+    out << "\nnamespace unit" << unit << " {\n\n" << bodies.str() << "} //namespace unit" << unit << "\n";
+}
+
+/**
+ * Writes statements inside nested try blocks. Handlers catch classes
+ * from the hierarchy, derived before base, and some rethrow.
+ * @param out The stream to write to.
+ * @param unit The unit number.
+ * @param function The function number.
+ * @param nesting How many try blocks to wrap the statements in.
+ * @param statements The statements, one per line.
+ */
+void CorpusGenerator::writeBody(ostream& out, int unit, int function, int nesting, const string& statements){
+    //Indents every line of the statements to the innermost block.
+    string indent(4 * (nesting + 1), ' ');
+    string body;
+    istringstream lines(statements);
+    string line;
+    while (getline(lines, line)) body += indent + line + "\n";
+
+    for (int level = nesting; level > 0; level--){
+        string outer(4 * level, ' ');
+
+        //The handled class gets closer to the root at outer levels.
+        int handled = pick(getNumExceptions());
+        for (int up = 0; up < nesting - level && exceptionParents[handled] >= 0; up++) handled = exceptionParents[handled];
+
+        string wrapped = outer + "try {\n" + body + outer + "} catch (const " + exceptionName(handled) + "& error) {\n";
+        if (chance(settings.rethrowRate)){
+            wrapped += outer + "    throw;\n";
+        } else {
+            wrapped += outer + "    value = " + to_string(unit + function) + ";\n";
+        }
+        if (level == 1) wrapped += outer + "} catch (...) {\n" + outer + "    value = -1;\n";
+        wrapped += outer + "}\n";
+        body = wrapped;
+    }
+    out << body;
+}
+
+/**
+ * Writes the compilation database for every unit.
+ * @param out The stream to write to.
+ * @param directory The absolute corpus directory.
+ */
+void CorpusGenerator::writeCompileCommands(ostream& out, const string& directory){
+    out << "[\n";
+    for (int i = 0; i < settings.units; i++){
+        string file = "src/unit" + to_string(i) + ".cpp";
+        out << "  {\n"
+            << "    \"directory\": \"" << directory << "\",\n"
+            << "    \"command\": \"" << settings.compiler << " -std=c++11 -Iinclude -c " << file << "\",\n"
+            << "    \"file\": \"" << file << "\"\n"
+            << "  }" << ((i + 1 < settings.units) ? "," : "") << "\n";
+    }
+    out << "]\n";
+}
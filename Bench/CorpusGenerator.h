@@ -0,0 +1,80 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// CorpusGenerator.h
+//
+// Writes a synthetic C++ project for end-to-end scaling
+// runs: translation units calling each other through a
+// layered call graph, an exception hierarchy, nested try
+// blocks, rethrows and shared headers, along with the
+// compile_commands.json that describes how to build them.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef ZELDA_CORPUSGENERATOR_H
+#define ZELDA_CORPUSGENERATOR_H
+
+#include <ostream>
+#include <random>
+#include <string>
+#include <vector>
+
+class CorpusGenerator {
+public:
+    struct Settings {
+        int units = 100;
+        int functions = 8;              //Functions per unit.
+        int depth = 6;                  //Layers of the call graph; units in a layer call the next.
+        int fanOut = 3;                 //Calls per function into the next layer.
+        int hierarchyDepth = 4;         //Levels of exception classes below the root.
+        int hierarchyWidth = 3;         //Subclasses of each exception class.
+        int tryDepth = 2;               //Largest nesting of try blocks.
+        double throwRate = 0.3;         //Chance a function throws directly.
+        double rethrowRate = 0.25;      //Chance a handler rethrows.
+        int sharedHeaders = 10;
+        int headerFunctions = 6;        //Inline functions per shared header.
+        int headersPerUnit = 3;         //Shared headers each unit includes.
+        unsigned int seed = 1;
+        std::string compiler = "clang++";
+    };
+
+    //Constructor
+    explicit CorpusGenerator(const Settings& settings);
+
+    //Generation
+    bool write(const std::string& directory, std::string& error);
+
+    //Getters
+    int getNumExceptions();
+
+private:
+    Settings settings;
+    std::mt19937 random;
+
+    //Parent of each exception class; the root has -1.
+    std::vector<int> exceptionParents;
+
+    int pick(int count);
+    bool chance(double probability);
+    std::vector<int> unitsInLayer(int layer);
+    std::string exceptionName(int index);
+
+    void writeExceptions(std::ostream& out);
+    void writeSharedHeader(std::ostream& out, int header);
+    void writeUnitHeader(std::ostream& out, int unit);
+    void writeUnit(std::ostream& out, int unit);
+    void writeBody(std::ostream& out, int unit, int function, int nesting, const std::string& statements);
+    void writeCompileCommands(std::ostream& out, const std::string& directory);
+};
+
+#endif //ZELDA_CORPUSGENERATOR_H
@@ -0,0 +1,305 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// PropagationBench.cpp
+//
+// Times exception propagation on synthetic graphs shaped
+// to stress it: deep recursion, wide fan-in to utility
+// functions and deep exception hierarchies. Runs the same
+// ExceptionFlow that ParentWalker::processExceptions runs
+// on each graph, without Clang.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include "BenchUtil.h"
+#include "SyntheticGraph.h"
+#include "../Graph/ExceptionFlow.h"
+#include "../Graph/PhaseStats.h"
+
+using namespace std;
+namespace po = boost::program_options;
+
+/** How densely functions throw and catch. */
+struct Shape {
+    double throwRate;
+    double tryRate;
+    double rethrowRate;
+    double catchAllRate;
+};
+
+/**
+ * Totals the counts of one category of a memory report.
+ * @param category The {count, bytes} entries by name.
+ * @return The total count.
+ */
+static long countEntries(const Json::Value& category){
+    long total = 0;
+    for (auto& name : category.getMemberNames()) total += category[name]["count"].asInt64();
+    return total;
+}
+
+/**
+ * Checks that the metrics of every throw agree with its destinations:
+ * it escapes exactly when a function is among them, is counted as
+ * handled once per catch among them, and has a route exactly when
+ * it has any destination.
+ * @param flow A flow that has been run.
+ * @param metrics The metrics measure() gave.
+ * @return The number of throws that disagree. Each is reported on stderr.
+ */
+static int checkMetrics(ExceptionFlow* flow, const vector<ExceptionFlow::ThrowMetrics>& metrics){
+    int mismatches = 0;
+    for (auto& cur : metrics){
+        vector<ZeldaNode*> destinations = flow->queryDestinations(cur.throwNode);
+        bool escapes = false;
+        int catches = 0;
+        for (ZeldaNode* destination : destinations){
+            if (destination->getType() == ZeldaNode::FUNCTION) escapes = true;
+            if (destination->getType() == ZeldaNode::CATCH) catches++;
+        }
+        if (cur.escapes == escapes && cur.handlers == catches && (cur.frames == -1) == destinations.empty()) continue;
+
+        mismatches++;
+        cerr << "Mismatch for " << cur.throwNode->getID() << ": measured escapes=" << cur.escapes
+             << " handlers=" << cur.handlers << " frames=" << cur.frames << ", but " << destinations.size()
+             << " destinations with escapes=" << escapes << " catches=" << catches << endl;
+    }
+    return mismatches;
+}
+
+/**
+ * Gives a function its exception behaviour: maybe a try block with
+ * catches of a few classes, and maybe a throw inside it.
+ * @param synthetic The generator.
+ * @param graph The graph to add to.
+ * @param function The function.
+ * @param classes The exception classes to throw and catch.
+ * @param shape How densely to throw and catch.
+ * @return The scope the function's calls should be made from.
+ */
+static ZeldaNode* addBody(SyntheticGraph& synthetic, TAGraph* graph, ZeldaNode* function,
+                          const vector<ZeldaNode*>& classes, const Shape& shape){
+    ZeldaNode* scope = function;
+    if (synthetic.chance(shape.tryRate)){
+        vector<ZeldaNode*> handled;
+        for (int i = synthetic.uniform(3); i >= 0; i--) handled.push_back(classes[synthetic.uniform((int) classes.size())]);
+        scope = synthetic.addTry(graph, function, handled, synthetic.chance(shape.catchAllRate), shape.rethrowRate);
+    }
+    if (synthetic.chance(shape.throwRate)) synthetic.addThrow(graph, scope, classes[synthetic.uniform((int) classes.size())]);
+    return scope;
+}
+
+/**
+ * Picks where one call is made from. Calls usually come from the scope
+ * addBody gave, and sometimes from the body of one of its catches.
+ * @param synthetic The generator.
+ * @param scope The function or try.
+ * @return The calling scope.
+ */
+static ZeldaNode* caller(SyntheticGraph& synthetic, ZeldaNode* scope){
+    const vector<ZeldaNode*>& handlers = scope->getHandlers();
+    if (handlers.empty() || !synthetic.chance(0.25)) return scope;
+    return handlers[synthetic.uniform((int) handlers.size())];
+}
+
+/**
+ * Builds a long call chain cut into recursive cycles. Each function
+ * calls the next, some call themselves, and the last of every cycle
+ * calls back to its first, so propagation walks long strongly
+ * connected components one after another.
+ * @param synthetic The generator.
+ * @param graph The graph to build.
+ * @param nodes The number of functions.
+ * @param cycle The functions per cycle.
+ * @param shape How densely to throw and catch.
+ */
+static void buildRecursion(SyntheticGraph& synthetic, TAGraph* graph, int nodes, int cycle, const Shape& shape){
+    vector<ZeldaNode*> classes = synthetic.addExceptionClasses(graph, 2, 3);
+    vector<ZeldaNode*> functions = synthetic.addFunctions(graph, 0, nodes);
+    synthetic.addModules(graph, functions);
+    for (int i = 0; i < nodes; i++){
+        ZeldaNode* scope = addBody(synthetic, graph, functions[i], classes, shape);
+        if (i + 1 < nodes) synthetic.addCall(graph, caller(synthetic, scope), functions[i + 1]);
+        if (synthetic.chance(0.5)) synthetic.addCall(graph, caller(synthetic, scope), functions[i]);
+        if (i % cycle == cycle - 1) synthetic.addCall(graph, caller(synthetic, scope), functions[i - cycle + 1]);
+    }
+}
+
+/**
+ * Builds many callers sharing a few throwing utility functions, picked
+ * by a power law so a handful of them are called from everywhere.
+ * Callers also call a later caller, so handlers sit at several depths.
+ * @param synthetic The generator.
+ * @param graph The graph to build.
+ * @param nodes The number of functions.
+ * @param degree The utility calls per caller.
+ * @param alpha The power-law exponent of utility use.
+ * @param shape How densely to throw and catch.
+ */
+static void buildFanIn(SyntheticGraph& synthetic, TAGraph* graph, int nodes, double degree, double alpha,
+                       const Shape& shape){
+    vector<ZeldaNode*> classes = synthetic.addExceptionClasses(graph, 2, 4);
+    int utilities = max(1, nodes / 100);
+    vector<ZeldaNode*> functions = synthetic.addFunctions(graph, 0, nodes);
+    synthetic.addModules(graph, functions);
+
+    //Utilities throw more than callers do, and never catch.
+    Shape utility = {min(1.0, shape.throwRate * 3), 0, 0, 0};
+    for (int i = 0; i < utilities; i++) addBody(synthetic, graph, functions[i], classes, utility);
+
+    vector<ZeldaNode*> scopes;
+    for (int i = utilities; i < nodes; i++) scopes.push_back(addBody(synthetic, graph, functions[i], classes, shape));
+    synthetic.setSkew(utilities, alpha);
+    for (int i = utilities; i < nodes; i++){
+        ZeldaNode* scope = scopes[i - utilities];
+        for (int j = 0; j < degree; j++) synthetic.addCall(graph, caller(synthetic, scope), functions[synthetic.skewed()]);
+        if (i + 1 < nodes) synthetic.addCall(graph, caller(synthetic, scope), functions[i + 1 + synthetic.uniform(nodes - i - 1)]);
+    }
+}
+
+/**
+ * Builds a layered call graph over a deep exception hierarchy, so
+ * most handler checks have to walk the hierarchy to match.
+ * @param synthetic The generator.
+ * @param graph The graph to build.
+ * @param nodes The number of functions.
+ * @param degree The calls per function.
+ * @param depth The levels of exception classes.
+ * @param width The subclasses of each exception class.
+ * @param shape How densely to throw and catch.
+ */
+static void buildHierarchy(SyntheticGraph& synthetic, TAGraph* graph, int nodes, double degree, int depth, int width,
+                           const Shape& shape){
+    vector<ZeldaNode*> classes = synthetic.addExceptionClasses(graph, depth, width);
+    vector<ZeldaNode*> functions = synthetic.addFunctions(graph, 0, nodes);
+    synthetic.addModules(graph, functions);
+    for (int i = 0; i < nodes; i++){
+        ZeldaNode* scope = addBody(synthetic, graph, functions[i], classes, shape);
+        for (int j = 0; j < degree && i + 1 < nodes; j++){
+            synthetic.addCall(graph, caller(synthetic, scope), functions[i + 1 + synthetic.uniform(nodes - i - 1)]);
+        }
+    }
+}
+
+int main(int argc, const char** argv){
+    Shape shape;
+    po::options_description desc("Options");
+    desc.add_options()
+            ("help,h", "Prints this help message.")
+            ("scenario", po::value<string>()->default_value("all"), "recursion, fanin, hierarchy or all.")
+            ("nodes", po::value<int>()->default_value(20000), "Number of functions in each graph.")
+            ("degree", po::value<double>()->default_value(3), "Calls per function.")
+            ("alpha", po::value<double>()->default_value(1.0), "Power-law exponent of utility use.")
+            ("cycle", po::value<int>()->default_value(64), "Functions per recursive cycle.")
+            ("hierarchy-depth", po::value<int>()->default_value(8), "Levels of exception classes.")
+            ("hierarchy-width", po::value<int>()->default_value(2), "Subclasses of each exception class.")
+            ("throw-rate", po::value<double>(&shape.throwRate)->default_value(0.2), "Chance a function throws.")
+            ("try-rate", po::value<double>(&shape.tryRate)->default_value(0.2), "Chance a function has a try block.")
+            ("rethrow-rate", po::value<double>(&shape.rethrowRate)->default_value(0.1), "Chance a catch rethrows.")
+            ("catch-all-rate", po::value<double>(&shape.catchAllRate)->default_value(0.1),
+             "Chance a try ends with catch (...).")
+            ("threads,j", po::value<int>()->default_value(1), "Propagation threads. Zero uses every core.")
+            ("seed", po::value<unsigned int>()->default_value(1), "Random seed.")
+            ("stats", po::value<string>(), "Writes the time of each propagation phase to this file.")
+            ("check", "Checks every throw's metrics against its destinations after timing.")
+            ("csv", "Prints CSV (scenario,nodes,edges,throws,buildSeconds,runSeconds,measureSeconds).");
+
+    po::variables_map vm;
+    int status;
+    if (!parseOptions(argc, argv, desc, vm, status)) return status;
+
+    int nodes = vm["nodes"].as<int>();
+    double degree = vm["degree"].as<double>();
+    int cycle = vm["cycle"].as<int>();
+    int threads = vm["threads"].as<int>();
+    string scenario = vm["scenario"].as<string>();
+    bool csv = vm.count("csv") > 0;
+    if (nodes < 2 || cycle < 1 || cycle > nodes){
+        cerr << "Error: need at least two nodes and a cycle between one and the number of nodes." << endl;
+        return 1;
+    }
+
+    vector<pair<string, function<void(SyntheticGraph&, TAGraph*)>>> scenarios = {
+            {"recursion", [&](SyntheticGraph& synthetic, TAGraph* graph){
+                buildRecursion(synthetic, graph, nodes, cycle, shape);
+            }},
+            {"fanin", [&](SyntheticGraph& synthetic, TAGraph* graph){
+                buildFanIn(synthetic, graph, nodes, degree, vm["alpha"].as<double>(), shape);
+            }},
+            {"hierarchy", [&](SyntheticGraph& synthetic, TAGraph* graph){
+                buildHierarchy(synthetic, graph, nodes, degree, vm["hierarchy-depth"].as<int>(),
+                               vm["hierarchy-width"].as<int>(), shape);
+            }}
+    };
+    if (scenario != "all"){
+        auto it = find_if(scenarios.begin(), scenarios.end(), [&scenario](const pair<string, function<void(SyntheticGraph&, TAGraph*)>>& cur) -> bool {
+            return cur.first == scenario;
+        });
+        if (it == scenarios.end()){
+            cerr << "Error: unknown scenario " << scenario << "." << endl;
+            return 1;
+        }
+        scenarios = {*it};
+    }
+
+    if (vm.count("stats")) PhaseStats::setEnabled(true);
+    //Tables show milliseconds and CSV shows seconds.
+    vector<int> widths = {12, 10, 10, 10, 12, 12, 12};
+    double scale = (csv) ? 1 : 1000;
+    if (csv){
+        printRow({"scenario", "nodes", "edges", "throws", "buildSeconds", "runSeconds", "measureSeconds"}, widths, csv);
+    } else {
+        printRow({"scenario", "nodes", "edges", "throws", "build ms", "run ms", "measure ms"}, widths, csv);
+    }
+
+    int mismatches = 0;
+    for (auto& cur : scenarios){
+        //Every scenario starts from the same seed so they can be run one at a time.
+        SyntheticGraph synthetic(vm["seed"].as<unsigned int>());
+        TAGraph* graph = new TAGraph();
+        double build = timeOnce([&]{ cur.second(synthetic, graph); });
+        Json::Value memory = graph->memoryReport().toJson();
+        long graphNodes = countEntries(memory["nodes"]);
+        long graphEdges = countEntries(memory["edges"]);
+        int throws = (int) graph->findNodesByType(ZeldaNode::THROW).size();
+
+        ExceptionFlow* flow = new ExceptionFlow(graph, threads);
+        double run;
+        {
+            PhaseStats::Timer timer("processExceptions", cur.first);
+            run = timeOnce([&]{ flow->run(); });
+        }
+        vector<ExceptionFlow::ThrowMetrics> metrics;
+        double measure = timeOnce([&]{ metrics = flow->measure(); });
+        if (vm.count("check")) mismatches += checkMetrics(flow, metrics);
+
+        printRow({cur.first, to_string(graphNodes), to_string(graphEdges), to_string(throws),
+                  formatNumber(build * scale, csv), formatNumber(run * scale, csv), formatNumber(measure * scale, csv)},
+                 widths, csv);
+        delete flow;
+        delete graph;
+    }
+
+    if (vm.count("stats") && !PhaseStats::save(vm["stats"].as<string>())){
+        cerr << "Error writing to " << vm["stats"].as<string>() << "!" << endl;
+        return 1;
+    }
+    if (mismatches > 0){
+        cerr << mismatches << " throws have metrics that disagree with their destinations." << endl;
+        return 1;
+    }
+    return 0;
+}
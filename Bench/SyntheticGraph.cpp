@@ -0,0 +1,284 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// SyntheticGraph.cpp
+//
+// Builds graphs shaped like the ones the walkers record.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include "SyntheticGraph.h"
+
+using namespace std;
+
+//Functions per class and classes per namespace in generated names.
+static const int CLASS_SIZE = 16;
+static const int NAMESPACE_SIZE = 64;
+
+/**
+ * Creates a generator. The same seed always builds the same graphs.
+ * @param seed The random seed.
+ */
+SyntheticGraph::SyntheticGraph(unsigned int seed) : random(seed), scopes(0) {
+    setSkew(1, 0);
+}
+
+/**
+ * Sets the power law skewed() samples from.
+ * @param count The number of indices.
+ * @param alpha The exponent. Zero picks uniformly; larger values favour low indices more.
+ */
+void SyntheticGraph::setSkew(int count, double alpha){
+    cumulative.assign(max(count, 1), 0);
+    double total = 0;
+    for (int i = 0; i < cumulative.size(); i++){
+        total += 1 / pow(i + 1, alpha);
+        cumulative[i] = total;
+    }
+}
+
+/**
+ * Picks an index from the power law set by setSkew.
+ * @return The index.
+ */
+int SyntheticGraph::skewed(){
+    uniform_real_distribution<double> pick(0, cumulative.back());
+    return (int) (upper_bound(cumulative.begin(), cumulative.end(), pick(random)) - cumulative.begin());
+}
+
+/**
+ * Picks an index uniformly.
+ * @param count The number of indices.
+ * @return The index.
+ */
+int SyntheticGraph::uniform(int count){
+    uniform_int_distribution<int> pick(0, count - 1);
+    return pick(random);
+}
+
+/**
+ * Flips a biased coin.
+ * @param probability The chance of true.
+ * @return The outcome.
+ */
+bool SyntheticGraph::chance(double probability){
+    uniform_real_distribution<double> pick(0, 1);
+    return pick(random) < probability;
+}
+
+/**
+ * Gets the qualified name of a generated function.
+ * @param index The function number.
+ * @return The name.
+ */
+string SyntheticGraph::functionName(int index){
+    ostringstream name;
+    name << "bench" << index / (CLASS_SIZE * NAMESPACE_SIZE) << "::Module" << index / CLASS_SIZE
+         << "::function" << index;
+    return name.str();
+}
+
+/**
+ * Gets the ID of a generated function, in the form the walkers give declarations.
+ * @param index The function number.
+ * @return The ID.
+ */
+string SyntheticGraph::functionID(int index){
+    return functionName(index) + "(int, const std::string &)";
+}
+
+/**
+ * Adds function nodes to a graph.
+ * @param graph The graph to add to.
+ * @param first The number of the first function.
+ * @param count How many functions to add.
+ * @return The new nodes, in order.
+ */
+vector<ZeldaNode*> SyntheticGraph::addFunctions(TAGraph* graph, int first, int count){
+    vector<ZeldaNode*> functions;
+    functions.reserve(count);
+    for (int i = first; i < first + count; i++){
+        ZeldaNode* node = new ZeldaNode(functionID(i), functionName(i), ZeldaNode::FUNCTION);
+        node->addSingleAttribute("filename", "bench/module" + to_string(i / CLASS_SIZE) + ".cpp");
+        graph->addNode(node);
+        functions.push_back(node);
+    }
+    return functions;
+}
+
+/**
+ * Adds calls between functions. Both callers and callees follow the
+ * power law, so low-numbered functions become hubs in both directions.
+ * Some calls only know their callee by a declaration ID that is not in
+ * the graph, as calls into other units do before they are merged. Half
+ * of those can be resolved by name and half name functions never seen.
+ * @param graph The graph to add to.
+ * @param functions The functions to connect.
+ * @param degree The average number of calls per function.
+ * @param alpha The power-law exponent of callers and callees.
+ * @param unresolved The fraction of calls whose callee is not linked.
+ * @return The number of calls added.
+ */
+int SyntheticGraph::addCalls(TAGraph* graph, const vector<ZeldaNode*>& functions, double degree, double alpha,
+                             double unresolved){
+    if (functions.empty()) return 0;
+    setSkew((int) functions.size(), alpha);
+    int calls = (int) (functions.size() * degree);
+    for (int i = 0; i < calls; i++){
+        ZeldaNode* caller = functions[skewed()];
+        int callee = skewed();
+        ZeldaEdge* edge;
+        if (chance(unresolved)){
+            string name = (chance(0.5)) ? functions[callee]->getName() : functionName((int) functions.size() + callee);
+            edge = new ZeldaEdge(caller, name + "(...)", ZeldaEdge::CALLS);
+            edge->setDestName(name);
+        } else {
+            edge = new ZeldaEdge(caller, functions[callee], ZeldaEdge::CALLS);
+        }
+        graph->addEdge(edge);
+    }
+    return calls;
+}
+
+/**
+ * Groups functions into classes as their generated names do, with a
+ * CONTAINS edge from each class to its functions.
+ * @param graph The graph to add to.
+ * @param functions The functions to group.
+ * @return The new classes.
+ */
+vector<ZeldaNode*> SyntheticGraph::addModules(TAGraph* graph, const vector<ZeldaNode*>& functions){
+    vector<ZeldaNode*> modules;
+    for (ZeldaNode* function : functions){
+        string name = function->getName().substr(0, function->getName().rfind("::"));
+        ZeldaNode* module = graph->findNode(name);
+        if (!module){
+            module = new ZeldaNode(name, name, ZeldaNode::CLASS);
+            graph->addNode(module);
+            modules.push_back(module);
+        }
+        graph->addEdge(new ZeldaEdge(module, function, ZeldaEdge::CONTAINS));
+    }
+    return modules;
+}
+
+/**
+ * Adds a tree of exception classes, each with width subclasses.
+ * INHERITS edges run from the base class to the derived class.
+ * @param graph The graph to add to.
+ * @param depth The levels below the root.
+ * @param width The subclasses of each class.
+ * @return The classes, root first and each level after the one above it.
+ */
+vector<ZeldaNode*> SyntheticGraph::addExceptionClasses(TAGraph* graph, int depth, int width){
+    vector<ZeldaNode*> classes;
+    auto addClass = [&](ZeldaNode* base){
+        string name = "bench::Error" + to_string(classes.size());
+        ZeldaNode* node = new ZeldaNode(name, name, ZeldaNode::CLASS);
+        graph->addNode(node);
+        if (base) graph->addEdge(new ZeldaEdge(base, node, ZeldaEdge::INHERITS));
+        classes.push_back(node);
+    };
+
+    addClass(nullptr);
+    int levelStart = 0;
+    for (int level = 0; level < depth; level++){
+        int levelEnd = (int) classes.size();
+        for (int base = levelStart; base < levelEnd; base++){
+            for (int i = 0; i < width; i++) addClass(classes[base]);
+        }
+        levelStart = levelEnd;
+    }
+    return classes;
+}
+
+/**
+ * Adds a call from a function, try or catch to a function. Calls are
+ * CONTEXT edges, as the walkers record them.
+ * @param graph The graph to add to.
+ * @param scope The calling scope.
+ * @param callee The function called.
+ */
+void SyntheticGraph::addCall(TAGraph* graph, ZeldaNode* scope, ZeldaNode* callee){
+    graph->addEdge(new ZeldaEdge(scope, callee, ZeldaEdge::CONTEXT));
+}
+
+/**
+ * Adds a try block with a catch for each handled class, in order.
+ * @param graph The graph to add to.
+ * @param scope The function, try or catch the block is in.
+ * @param handled The classes caught.
+ * @param catchAll Whether a catch (...) comes last.
+ * @param rethrowRate The chance each catch rethrows.
+ * @return The try. Its catches are its handlers.
+ */
+ZeldaNode* SyntheticGraph::addTry(TAGraph* graph, ZeldaNode* scope, const vector<ZeldaNode*>& handled, bool catchAll,
+                                  double rethrowRate){
+    ZeldaNode* tryNode = new ZeldaNode("bench::try" + to_string(scopes++), "try", ZeldaNode::TRY);
+    graph->addNode(tryNode);
+    addScope(graph, scope, tryNode);
+
+    int count = (int) handled.size() + catchAll;
+    for (int i = 0; i < count; i++){
+        ZeldaNode* catchNode = new ZeldaNode("bench::catch" + to_string(scopes++), "catch", ZeldaNode::CATCH);
+        catchNode->addSingleAttribute("type", (i < handled.size()) ? "const " + handled[i]->getName() + " &" : "all");
+        catchNode->addCountAttribute("order", i);
+        graph->addNode(catchNode);
+        addScope(graph, tryNode, catchNode);
+
+        if (chance(rethrowRate)){
+            ZeldaNode* rethrow = new ZeldaNode("bench::rethrow" + to_string(scopes++), "rethrow", ZeldaNode::RETHROW);
+            graph->addNode(rethrow);
+            graph->addEdge(new ZeldaEdge(catchNode, rethrow, ZeldaEdge::RETHROWS));
+            rethrow->setScope(catchNode);
+        }
+    }
+    return tryNode;
+}
+
+/**
+ * Adds a throw of a class.
+ * @param graph The graph to add to.
+ * @param scope The function, try or catch that throws.
+ * @param type The class thrown.
+ * @return The throw.
+ */
+ZeldaNode* SyntheticGraph::addThrow(TAGraph* graph, ZeldaNode* scope, ZeldaNode* type){
+    ZeldaNode* throwNode = new ZeldaNode("bench::throw" + to_string(scopes++), "throw", ZeldaNode::THROW);
+    throwNode->addSingleAttribute("type", type->getName());
+    string file = scope->getSingleAttribute("filename");
+    if (!file.empty()) throwNode->addSingleAttribute("filename", file);
+    graph->addNode(throwNode);
+    graph->addEdge(new ZeldaEdge(scope, throwNode, ZeldaEdge::THROWS));
+    throwNode->setScope(scope);
+    return throwNode;
+}
+
+/**
+ * Nests a try or catch in a scope and links it the way the walkers do.
+ * @param graph The graph to add to.
+ * @param parent The enclosing function, try or catch.
+ * @param scope The nested try or catch.
+ */
+void SyntheticGraph::addScope(TAGraph* graph, ZeldaNode* parent, ZeldaNode* scope){
+    graph->addEdge(new ZeldaEdge(parent, scope, ZeldaEdge::CONTEXT));
+    scope->addSingleAttribute("context", parent->getName());
+    scope->setScope(parent);
+    if (scope->getType() == ZeldaNode::CATCH){
+        scope->setOwner(parent);
+        parent->addHandler(scope);
+    }
+}
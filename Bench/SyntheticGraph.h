@@ -0,0 +1,72 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// SyntheticGraph.h
+//
+// Builds graphs shaped like the ones the walkers record,
+// without Clang, so the graph layer can be benchmarked on
+// its own. Degrees follow a power law so a few functions
+// act as hubs, as utility functions do in real code.
+// Exception scopes, throws and class hierarchies can be
+// added to drive exception propagation.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef ZELDA_SYNTHETICGRAPH_H
+#define ZELDA_SYNTHETICGRAPH_H
+
+#include <random>
+#include <string>
+#include <vector>
+#include "../Graph/TAGraph.h"
+
+class SyntheticGraph {
+public:
+    //Constructor
+    explicit SyntheticGraph(unsigned int seed = 1);
+
+    //Sampling
+    void setSkew(int count, double alpha);
+    int skewed();
+    int uniform(int count);
+    bool chance(double probability);
+
+    //Naming
+    static std::string functionName(int index);
+    static std::string functionID(int index);
+
+    //Builders
+    std::vector<ZeldaNode*> addFunctions(TAGraph* graph, int first, int count);
+    int addCalls(TAGraph* graph, const std::vector<ZeldaNode*>& functions, double degree, double alpha, double unresolved);
+    std::vector<ZeldaNode*> addModules(TAGraph* graph, const std::vector<ZeldaNode*>& functions);
+
+    //Exception Builders
+    std::vector<ZeldaNode*> addExceptionClasses(TAGraph* graph, int depth, int width);
+    void addCall(TAGraph* graph, ZeldaNode* scope, ZeldaNode* callee);
+    ZeldaNode* addTry(TAGraph* graph, ZeldaNode* scope, const std::vector<ZeldaNode*>& handled, bool catchAll,
+                      double rethrowRate);
+    ZeldaNode* addThrow(TAGraph* graph, ZeldaNode* scope, ZeldaNode* type);
+
+private:
+    std::mt19937 random;
+
+    //Picks index i with weight 1 / (i + 1)^alpha.
+    std::vector<double> cumulative;
+
+    //Numbers the try, catch and throw nodes.
+    int scopes;
+
+    void addScope(TAGraph* graph, ZeldaNode* parent, ZeldaNode* scope);
+};
+
+#endif //ZELDA_SYNTHETICGRAPH_H
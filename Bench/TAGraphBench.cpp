@@ -0,0 +1,158 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// TAGraphBench.cpp
+//
+// Times the TAGraph operations the walkers and the merge
+// rely on, on synthetic graphs with power-law degrees.
+// Runs without Clang. The defaults finish in a few seconds.
+// Lookups scale with --nodes; merging, purging and writing
+// the model grow faster than linearly, so they run on a
+// graph of at most --bulk-nodes functions, which has to be
+// raised separately to time them on larger graphs.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include "BenchUtil.h"
+#include "SyntheticGraph.h"
+
+using namespace std;
+namespace po = boost::program_options;
+
+/**
+ * Prints one result line.
+ * @param name The operation.
+ * @param operations How many times it ran.
+ * @param seconds How long all of them took.
+ * @param csv Whether to print CSV instead of a table.
+ */
+static void report(const string& name, long operations, double seconds, bool csv){
+    double perOperation = (operations > 0) ? seconds * 1e9 / operations : 0;
+    if (csv){
+        printRow({name, to_string(operations), formatNumber(seconds, true), formatNumber(perOperation, true)}, {}, true);
+        return;
+    }
+    printRow({name, to_string(operations), formatNumber(seconds * 1000, false) + " ms",
+              formatNumber(perOperation, false) + " ns/op"}, {28, 10, 15, 20}, false);
+}
+
+int main(int argc, const char** argv){
+    po::options_description desc("Options");
+    desc.add_options()
+            ("help,h", "Prints this help message.")
+            ("nodes", po::value<int>()->default_value(10000), "Number of functions in the graph.")
+            ("bulk-nodes", po::value<int>()->default_value(10000),
+             "Most functions in the graph that merge, purgeUnestablishedEdges and getTAModel run on.")
+            ("degree", po::value<double>()->default_value(4), "Average calls per function.")
+            ("alpha", po::value<double>()->default_value(1.0), "Power-law exponent of call degrees (0 is uniform).")
+            ("unresolved", po::value<double>()->default_value(0.01), "Fraction of calls whose callee is not linked.")
+            ("lookups", po::value<int>()->default_value(100000), "Number of hashed lookups per operation.")
+            ("hubs", po::value<int>()->default_value(1000), "Number of lookups per operation that land on hubs.")
+            ("scans", po::value<int>()->default_value(100), "Number of lookups per operation that scan every node.")
+            ("seed", po::value<unsigned int>()->default_value(1), "Random seed.")
+            ("out", po::value<string>()->default_value("TAGraphBench.ta"), "Where getTAModel writes.")
+            ("csv", "Prints CSV (operation,count,seconds,ns per op).");
+
+    po::variables_map vm;
+    int status;
+    if (!parseOptions(argc, argv, desc, vm, status)) return status;
+
+    int nodes = vm["nodes"].as<int>();
+    int bulkNodes = min(nodes, vm["bulk-nodes"].as<int>());
+    double degree = vm["degree"].as<double>();
+    double alpha = vm["alpha"].as<double>();
+    double unresolved = vm["unresolved"].as<double>();
+    int lookups = vm["lookups"].as<int>();
+    int hubs = vm["hubs"].as<int>();
+    int scans = vm["scans"].as<int>();
+    string out = vm["out"].as<string>();
+    bool csv = vm.count("csv") > 0;
+    if (bulkNodes < 2){
+        cerr << "Error: need at least two nodes and two bulk nodes." << endl;
+        return 1;
+    }
+
+    SyntheticGraph synthetic(vm["seed"].as<unsigned int>());
+    TAGraph* graph = new TAGraph();
+    vector<ZeldaNode*> functions;
+    int calls = 0;
+    if (csv) printRow({"operation", "count", "seconds", "nsPerOp"}, {}, true);
+
+    report("addNode", nodes, timeOnce([&]{ functions = synthetic.addFunctions(graph, 0, nodes); }), csv);
+    report("addEdge", (long) (nodes * degree), timeOnce([&]{
+        calls = synthetic.addCalls(graph, functions, degree, alpha, unresolved);
+    }), csv);
+
+    //Low numbers are the hubs, so most of these scan a long edge list and miss.
+    synthetic.setSkew(nodes, alpha);
+    int found = 0;
+    report("doesEdgeExist (hubs)", hubs, timeOnce([&]{
+        for (int i = 0; i < hubs; i++){
+            ZeldaNode* src = functions[synthetic.skewed()];
+            ZeldaNode* dst = functions[synthetic.uniform(nodes)];
+            found += graph->doesEdgeExist(src->getID(), dst->getID(), ZeldaEdge::CALLS);
+        }
+    }), csv);
+
+    report("findEdgesByTypeAndDst (hubs)", hubs, timeOnce([&]{
+        for (int i = 0; i < hubs; i++){
+            found += (int) graph->findEdgesByTypeAndDst(functions[synthetic.skewed()], ZeldaEdge::CALLS).size();
+        }
+    }), csv);
+
+    //Keys are made up front so only the lookups are timed.
+    vector<string> ids, names, endNames;
+    for (int i = 0; i < lookups; i++) ids.push_back(SyntheticGraph::functionID(synthetic.uniform(nodes)));
+    for (int i = 0; i < scans; i++){
+        names.push_back(SyntheticGraph::functionName(synthetic.uniform(nodes)));
+        endNames.push_back(names.back().substr(names.back().rfind("::") + 2));
+    }
+
+    report("findNode", lookups, timeOnce([&]{
+        for (auto& id : ids) found += graph->findNode(id) != nullptr;
+    }), csv);
+    report("findNodeByName", scans, timeOnce([&]{
+        for (auto& name : names) found += graph->findNodeByName(name) != nullptr;
+    }), csv);
+    report("findNodeByEndName", scans, timeOnce([&]{
+        for (auto& name : endNames) found += graph->findNodeByEndName(name) != nullptr;
+    }), csv);
+
+    //The main graph is reused when it is small enough.
+    TAGraph* bulk = graph;
+    int bulkCalls = calls;
+    if (bulkNodes < nodes){
+        bulk = new TAGraph();
+        bulkCalls = synthetic.addCalls(bulk, synthetic.addFunctions(bulk, 0, bulkNodes), degree, alpha, unresolved);
+    }
+
+    //The other graph shares half its functions with this one, as units sharing headers do.
+    TAGraph* other = new TAGraph();
+    vector<ZeldaNode*> otherFunctions = synthetic.addFunctions(other, bulkNodes / 2, bulkNodes);
+    synthetic.addCalls(other, otherFunctions, degree, alpha, unresolved);
+    report("merge", bulkNodes, timeOnce([&]{ bulk->merge(other); }), csv);
+    delete other;
+
+    report("purgeUnestablishedEdges", bulkCalls, timeOnce([&]{ bulk->purgeUnestablishedEdges(true); }), csv);
+    report("getTAModel", bulkNodes + bulkNodes / 2, timeOnce([&]{ bulk->getTAModel(out); }), csv);
+    remove(out.c_str());
+    if (bulk != graph) delete bulk;
+
+    //Keeps the lookups from being optimized away.
+    if (!csv) cout << endl << found << " lookups matched." << endl;
+    delete graph;
+    return 0;
+}
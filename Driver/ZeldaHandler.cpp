@@ -32,19 +32,85 @@
 #include <regex>
 #include <fstream>
 #include <boost/foreach.hpp>
+#include <algorithm>
+#include <atomic>
 #include "ZeldaHandler.h"
 #include "../Walker/ExceptConsumer.h"
 #include "../JSON/json.h"
+#include "../Graph/IncludeGraph.h"
+#include "../Graph/TraceLog.h"
+#include "../Graph/UnitTimes.h"
+#include "../Graph/FileTable.h"
+#include "../Graph/ThreadPool.h"
+#include "llvm/Config/llvm-config.h"
+#if LLVM_VERSION_MAJOR >= 9
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/TimeProfiler.h"
+#endif
+#if LLVM_VERSION_MAJOR >= 8
+#include "llvm/Support/VirtualFileSystem.h"
+#endif
 //#include "../Configuration/ScenarioWalker.h"
 
 using namespace std;
 using namespace clang::tooling;
 
+//Clang's threads are numbered from here in the trace so they stay apart from ours.
+static const int CLANG_TRACE_THREADS = 1000;
+
+//Shortest Clang event kept in the trace, in microseconds. Clang's -ftime-trace uses the same default.
+static const int CLANG_TRACE_GRANULARITY = 500;
+
+/**
+ * Starts Clang's time-trace profiler so its parse and Sema events can
+ * be merged into our trace.
+ * @return When the profiler started, on the trace's clock, or -1 if it did not.
+ */
+static long long startClangTrace(){
+#if LLVM_VERSION_MAJOR >= 9
+  if (!TraceLog::isEnabled()) return -1;
+  long long start = TraceLog::now();
+#if LLVM_VERSION_MAJOR >= 11
+  llvm::timeTraceProfilerInitialize(CLANG_TRACE_GRANULARITY, "Zelda");
+#elif LLVM_VERSION_MAJOR >= 10
+  llvm::timeTraceProfilerInitialize(CLANG_TRACE_GRANULARITY);
+#else
+  llvm::timeTraceProfilerInitialize();
+#endif
+  return start;
+#else
+  return -1;
+#endif
+}
+
+/**
+ * Stops Clang's time-trace profiler and merges what it recorded.
+ * @param start When the profiler started, from startClangTrace.
+ */
+static void finishClangTrace(long long start){
+#if LLVM_VERSION_MAJOR >= 9
+  if (start < 0) return;
+  llvm::SmallString<0> buffer;
+#if LLVM_VERSION_MAJOR >= 10
+  llvm::raw_svector_ostream out(buffer);
+  llvm::timeTraceProfilerWrite(out);
+#else
+  std::unique_ptr<llvm::raw_pwrite_stream> out(new llvm::raw_svector_ostream(buffer));
+  llvm::timeTraceProfilerWrite(out);
+  out.reset();
+#endif
+  llvm::timeTraceProfilerCleanup();
+  if (!TraceLog::addEvents(buffer.str().str(), start, CLANG_TRACE_THREADS)){
+    cerr << "Warning: Clang's time trace could not be merged." << endl;
+  }
+#endif
+}
+
 
 /**
  * Constructor that prepares the ZeldaHandler.
  */
-ZeldaHandler::ZeldaHandler():Category{"Zelda"}{
+ZeldaHandler::ZeldaHandler():Category{"Zelda"},jobs(1){
   //Sets the C, C++ extensions.
   ext.push_back(".C");
   ext.push_back(".c");
@@ -91,6 +157,31 @@ vector<string> ZeldaHandler::getFiles(){
 }
 
 
+/**
+ * Sets how many translation units are walked at once. Clang only
+ * gives each walk its own working directory from LLVM 8 on, so older
+ * versions always walk one unit at a time.
+ * @param jobs The number of units, or zero for one per core.
+ */
+void ZeldaHandler::setJobs(int jobs){
+  if (jobs <= 0) jobs = ThreadPool::defaultWorkers();
+#if LLVM_VERSION_MAJOR < 8
+  jobs = 1;
+#endif
+  this->jobs = jobs;
+}
+
+/**
+ * Loads the unit timings of an earlier run, used to estimate how
+ * long each unit will take.
+ * @param fileName The timing file of the earlier run.
+ * @return Whether the file could be read.
+ */
+bool ZeldaHandler::loadUnitHistory(std::string fileName){
+  history.clear();
+  return UnitTimes::load(fileName, history);
+}
+
 /**
  * Runs through all files in the queue and generates a graph.
  * @param minimalWalk Boolean that indicates what ZeldaWalker to use.
@@ -98,6 +189,28 @@ vector<string> ZeldaHandler::getFiles(){
  * @return Boolean indicating success.
  */
 bool ZeldaHandler::processAllFiles(){
+  //Remembers the units so they can be walked again later.
+  for (string file : getFileList()){
+    if (find(units.begin(), units.end(), file) == units.end()) units.push_back(file);
+  }
+
+  bool success = processFiles();
+
+  //Shifts the graphs.
+  ParentWalker::endCurrentGraph();
+
+  //Clears the graph.
+  files.clear();
+
+  //Returns the success code.
+  return success;
+}
+
+/**
+ * Walks the files in the queue into the current graph.
+ * @return Boolean indicating success.
+ */
+bool ZeldaHandler::processFiles(){
   bool success = true;
 
   //Creates the command line arguments.
@@ -112,14 +225,13 @@ bool ZeldaHandler::processAllFiles(){
   ExceptConsumer::setClassifyFile(current_path().string());
   cerr << current_path().string() << endl;
 
-  int fileSplit = getNumFiles();
-  for (int i = 0; i < getNumFiles(); i += fileSplit){
-
-    vector<string> toProcess;
-    toProcess = fileList;
+  //Clang's profiler is shared by every thread before LLVM 11, so it only runs for one.
+  //From LLVM 11 on it is per thread and only records the units walked on this one.
+  long long clangTrace = -1;
+  if (jobs <= 1 || LLVM_VERSION_MAJOR >= 11) clangTrace = startClangTrace();
 
-
-    ClangTool* Tool = new ClangTool(OptionsParser.getCompilations(), toProcess);
+  if (jobs <= 1 || fileList.size() <= 1){
+    ClangTool* Tool = new ClangTool(OptionsParser.getCompilations(), fileList);
     int code = Tool->run(newFrontendActionFactory<ZeldaAction>().get());
 
     //Gets the code and checks for warnings.
@@ -129,14 +241,28 @@ bool ZeldaHandler::processAllFiles(){
     }
 
     delete Tool;
+  } else {
+#if LLVM_VERSION_MAJOR >= 8
+    //Only the counting walk runs per unit and it merges under a lock. The graph
+    //walkers write to the shared graph and must not be enabled here as they are.
+    const vector<string> scheduled = scheduleFiles(fileList);
+    atomic<bool> failed(false);
+    ThreadPool pool(min(jobs, (int) scheduled.size()));
+    pool.parallelFor((int) scheduled.size(), [&](int index, int worker){
+      //Each walk gets its own file system so units can change directory independently.
+      llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> fileSystem(llvm::vfs::createPhysicalFileSystem().release());
+      ClangTool Tool(OptionsParser.getCompilations(), vector<string>(1, scheduled[index]),
+                     std::make_shared<PCHContainerOperations>(), fileSystem);
+      if (Tool.run(newFrontendActionFactory<ZeldaAction>().get()) != 0) failed = true;
+    });
+
+    if (failed) {
+      cerr << "Warning: Compilation errors were detected." << endl;
+      success = false;
+    }
+#endif
   }
-  
-
-  //Shifts the graphs.
-  ParentWalker::endCurrentGraph();
-
-  //Clears the graph.
-  files.clear();
+  finishClangTrace(clangTrace);
 
   //Cleans up memory.
   for (int i = 0; i  < argc; i++) delete argv[i];
@@ -147,6 +273,51 @@ bool ZeldaHandler::processAllFiles(){
 }
 
 
+/**
+ * Orders the units so the most expensive ones start first, letting the
+ * workers finish together. A unit is expected to take as long as it did
+ * last time; units never timed are estimated from their size, at the
+ * rate the timed units were walked.
+ * @param fileList The units to order.
+ * @return The units, most expensive first.
+ */
+vector<string> ZeldaHandler::scheduleFiles(const vector<string>& fileList){
+  //Times from this session are newer than the earlier run's.
+  map<string, UnitTimes::Entry> timed = history;
+  for (auto& entry : UnitTimes::getEntries()) timed[entry.first] = entry.second;
+
+  vector<double> costs(fileList.size(), -1);
+  vector<double> sizes(fileList.size(), 0);
+  double seconds = 0;
+  double bytes = 0;
+  for (int i = 0; i < fileList.size(); i++){
+    boost::system::error_code error;
+    uintmax_t size = file_size(fileList[i], error);
+    if (!error) sizes[i] = (double) size;
+
+    auto it = timed.find(ParentWalker::normalizeFileName(fileList[i]));
+    if (it == timed.end() || it->second.total() <= 0) continue;
+    costs[i] = it->second.total();
+    seconds += costs[i];
+    bytes += sizes[i];
+  }
+
+  double rate = (seconds > 0 && bytes > 0) ? seconds / bytes : 1;
+  for (int i = 0; i < fileList.size(); i++){
+    if (costs[i] < 0) costs[i] = sizes[i] * rate;
+  }
+
+  vector<int> order(fileList.size());
+  for (int i = 0; i < order.size(); i++) order[i] = i;
+  stable_sort(order.begin(), order.end(), [&costs](int first, int second) -> bool {
+    return costs[first] > costs[second];
+  });
+
+  vector<string> scheduled;
+  for (int i : order) scheduled.push_back(fileList[i]);
+  return scheduled;
+}
+
 /**
  * Outputs an individual TA model to TA format.
  * @param modelNum The number of the model to output.
@@ -174,6 +345,25 @@ bool ZeldaHandler::outputModel(std::string fileName){
   Counter::printData(1, catches);
   Counter::printData(2, nonExcept);
 
+  //Saves the include graph so later runs can pick the impacted units.
+  string includeFile = fileName + "/" + INCLUDE_FILENAME;
+  if (!IncludeGraph::save(includeFile)) cerr << "Error writing to " << includeFile << "!" << endl;
+
+  //Per-unit times and graph contributions, compared against by the next run.
+  if ( ParentWalker::getNumGraphs() > 0 ) {
+    TAGraph* merged = ParentWalker::getGraph(0);
+    for ( auto& entry : UnitTimes::getEntries() ) {
+      int unitID = FileTable::find( entry.first );
+      if ( unitID == FileTable::NO_FILE ) continue;
+      UnitTimes::recordContribution( entry.first, merged->countNodesByUnit( unitID ), merged->countEdgesByUnit( unitID ) );
+    }
+  }
+  string unitTimesFile = fileName + "/" + UNIT_TIMES_FILENAME;
+  if (!UnitTimes::save(unitTimesFile)) cerr << "Error writing to " << unitTimesFile << "!" << endl;
+
+  //Per-throw lengths, skipped when propagation did not run.
+  ParentWalker::generateExceptionMetrics(fileName + "/" + METRICS_FILENAME, fileName + "/" + HISTOGRAM_FILENAME);
+
   string taFile = fileName + "/" + DEFAULT_FILENAME + DEFAULT_EXT;
 
   //First, check if the number if valid.
@@ -219,6 +409,60 @@ bool ZeldaHandler::resolveComponents(std::vector<path> databasePaths){
 }
 
 
+/**
+ * Patches the resident graph after some files changed on disk. The
+ * units that recorded facts from those files are retracted and walked
+ * again, then exception flow is updated for what they contain.
+ * @param changed The changed, added or deleted files.
+ * @return Boolean indicating success.
+ */
+bool ZeldaHandler::patchFiles(std::vector<path> changed){
+  vector<string> names;
+  for (path file : changed){
+    names.push_back(ParentWalker::normalizeFileName(file.string()));
+  }
+
+  //Maps unit names back to the paths Clang needs, picking up new sources.
+  map<string, string> known;
+  for (string unit : units) known[ParentWalker::normalizeFileName(unit)] = unit;
+  for (int i = 0; i < changed.size(); i++){
+    if (known.count(names[i]) || !ParentWalker::isCFile(names[i]) || !exists(changed[i])) continue;
+    if (find(ext.begin(), ext.end(), extension(changed[i])) == ext.end()) continue;
+    string unit = canonical(changed[i]).string();
+    units.push_back(unit);
+    known[names[i]] = unit;
+  }
+
+  vector<string> retracted = ParentWalker::retractFiles(names);
+  files.clear();
+  for (string unit : retracted){
+    auto it = known.find(unit);
+    if (it != known.end() && exists(it->second)) files.push_back(it->second);
+  }
+
+  bool success = true;
+  ParentWalker::resumeGraph();
+  if (!files.empty()) success = processFiles();
+  ParentWalker::endPatch(retracted);
+  files.clear();
+
+  return success;
+}
+
+/**
+ * Drops every queued file that is not one of the given units.
+ * @param units The normalized names of the units to keep.
+ * @return The number of files left in the queue.
+ */
+int ZeldaHandler::keepFiles(const std::set<std::string>& units){
+  vector<path> kept;
+  for (path file : files){
+    if (units.count(ParentWalker::normalizeFileName(canonical(file).string()))) kept.push_back(file);
+  }
+  files = kept;
+  return (int) files.size();
+}
+
 /**
  * Adds a file/directory by path.
  * @param curPath The path to add.
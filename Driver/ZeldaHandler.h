@@ -29,6 +29,8 @@
 #ifndef REX_REXHANDLER_H
 #define REX_REXHANDLER_H
 
+#include <map>
+#include <set>
 #include <string>
 #include <vector>
 #include "clang/Frontend/FrontendAction.h"
@@ -36,6 +38,7 @@
 #include "clang/Tooling/CommonOptionsParser.h"
 #include <llvm/Support/CommandLine.h>
 #include <boost/filesystem.hpp>
+#include "../Graph/UnitTimes.h"
 
 using namespace boost::filesystem;
 
@@ -50,9 +53,14 @@ public:
     int getNumFiles();
     std::vector<std::string> getFiles();
 
+    /** Setters */
+    void setJobs(int jobs);
+    bool loadUnitHistory(std::string fileName);
+
     /** Processing Systems */
     bool processClangToolCode(int argc, const char** argv);
     bool processAllFiles();
+    bool patchFiles(std::vector<path> changed);
 
 
     /** Output Helpers */
@@ -63,11 +71,16 @@ public:
 
     /** Add and Remove Functions */
     int addByPath(path curPath);
+    int keepFiles(const std::set<std::string>& units);
 
 private:
     /** Default Arguments */
     const std::string DEFAULT_EXT = ".ta";
     const std::string DEFAULT_FILENAME = "out";
+    const std::string INCLUDE_FILENAME = "includes.json";
+    const std::string METRICS_FILENAME = "throwMetrics.csv";
+    const std::string HISTOGRAM_FILENAME = "throwHistograms.csv";
+    const std::string UNIT_TIMES_FILENAME = "unitTimes.json";
     const std::string DEFAULT_START = "./Zelda";
     const std::string INCLUDE_DIR = CLANG_INCLUD_DIR;
     const std::string INCLUDE_DIR_LOC = "--extra-arg=-I" + INCLUDE_DIR;
@@ -78,8 +91,15 @@ private:
 
     /** Member Variables */
     std::vector<path> files;
+    std::vector<std::string> units;
     std::vector<std::string> ext;
     llvm::cl::OptionCategory Category;
+    int jobs;
+    std::map<std::string, UnitTimes::Entry> history;
+
+    /** Processing Helper Methods */
+    bool processFiles();
+    std::vector<std::string> scheduleFiles(const std::vector<std::string>& fileList);
 
     /** Arg Helper Methods */
     char** prepareArgs(int *argc);
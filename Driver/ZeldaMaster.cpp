@@ -27,17 +27,28 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 /////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+#include <cstdio>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
 #include <pwd.h>
 #include <zconf.h>
+#include <set>
 #include <vector>
 #include <boost/algorithm/string/regex.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/program_options.hpp>
 #include <boost/make_shared.hpp>
 #include "ZeldaHandler.h"
+#include "ZeldaWatcher.h"
+#include "ZeldaServer.h"
 #include "../Walker/Classifier.h"
+#include "../Graph/IncludeGraph.h"
+#include "../Graph/LockWaits.h"
+#include "../Graph/PhaseStats.h"
+#include "../Graph/TraceLog.h"
+#include "../Graph/UnitTimes.h"
+#include "../Graph/VisitStats.h"
 
 using namespace std;
 using namespace boost::filesystem;
@@ -46,6 +57,15 @@ namespace po = boost::program_options;
 /** Zelda Command Handler */
 static ZeldaHandler* masterHandle;
 
+/** Where --stats writes the phase report in the output directory. */
+static const string STATS_FILENAME = "stats.json";
+
+/** Where the per-unit timings of a run are kept in its output directory. */
+static const string UNIT_TIMES_FILENAME = "unitTimes.json";
+
+/** How many of the slowest units are reported by default. */
+static const int DEFAULT_SLOWEST = 10;
+
 /**
  * Takes in a line and tokenizes it to
  * a vector by spaces.
@@ -96,6 +116,113 @@ string setupOutputDir(path& location){
 }
 
 
+/**
+ * Finds the output directory of the most recent run.
+ * @param location The directory the outputs are created in.
+ * @return The directory, or an empty string if there was no earlier run.
+ */
+string findPreviousOutputDir(path& location){
+  string outputDir = location.string() + "/ZeldaAnalysis";
+  string previous;
+  string attempt = outputDir;
+  int i = 2;
+  while ( exists(attempt) ){
+    previous = attempt;
+    ostringstream oss; oss << i;
+    attempt = outputDir + oss.str();
+    ++i;
+  }
+  return previous;
+}
+
+/**
+ * Quotes a string for the shell.
+ * @param str The string to quote.
+ * @return The quoted string.
+ */
+string shellQuote(const string& str){
+  string quoted = "'";
+  for ( char c : str ){
+    if ( c == '\'' ) quoted += "'\\''";
+    else quoted += c;
+  }
+  return quoted + "'";
+}
+
+/**
+ * Runs a command and collects its output line by line.
+ * @param command The command to run.
+ * @param lines Collects the output.
+ * @return Whether the command succeeded.
+ */
+bool runCommand(const string& command, vector<string>& lines){
+  FILE* pipe = popen(command.c_str(), "r");
+  if ( !pipe ) return false;
+
+  char buffer[4096];
+  string line;
+  while ( fgets(buffer, sizeof(buffer), pipe) ){
+    line += buffer;
+    if ( line.back() != '\n' ) continue;
+    line.pop_back();
+    lines.push_back(line);
+    line.clear();
+  }
+  if ( !line.empty() ) lines.push_back(line);
+  return pclose(pipe) == 0;
+}
+
+/**
+ * Lists the files changed in a git revision range.
+ * @param range The revision range, as git diff takes it.
+ * @param location A directory inside the repository.
+ * @param changed Collects the normalized names of the changed files.
+ * @return Whether git could be queried.
+ */
+bool gitChangedFiles(const string& range, path& location, set<string>& changed){
+  string git = "git -C " + shellQuote(location.string());
+  vector<string> top;
+  if ( !runCommand(git + " rev-parse --show-toplevel", top) || top.empty() ) return false;
+
+  vector<string> files;
+  if ( !runCommand(git + " diff --name-only " + shellQuote(range) + " --", files) ) return false;
+  for ( string file : files ){
+    changed.insert(ParentWalker::normalizeFileName(top[0] + "/" + file));
+  }
+  return true;
+}
+
+/**
+ * Restricts the queue to the units a git revision range can affect,
+ * using the include graph saved by the previous run. Falls back to
+ * analyzing everything when there is no usable earlier run.
+ * @param range The revision range.
+ * @param location The directory the outputs are created in.
+ */
+void selectImpactedUnits(const string& range, path& location){
+  string previous = findPreviousOutputDir(location);
+  if ( previous.empty() || !IncludeGraph::load(previous + "/includes.json") ){
+    cerr << "No include graph from an earlier run was found, analyzing everything." << endl;
+    return;
+  }
+
+  set<string> changed;
+  if ( !gitChangedFiles(range, location, changed) ){
+    cerr << "Could not list the changes in " << range << ", analyzing everything." << endl;
+    return;
+  }
+
+  //Changed sources the earlier run never saw are new units.
+  set<string> units = IncludeGraph::impactedUnits(changed);
+  for ( string file : changed ){
+    if ( ParentWalker::isCFile(file) && exists(file) ) units.insert(file);
+  }
+
+  int kept = masterHandle->keepFiles(units);
+  cout << changed.size() << " changed file(s) in " << range << " affect " << kept
+       << " translation unit(s)." << endl;
+}
+
 /**
  * Driver method for the OUTPUT argument.
  * Allows users to specify what graphs to output.
@@ -117,6 +244,41 @@ void outputGraphs(path& startDir){
     }
 }
 
+/**
+ * Prints the units that took longest to parse and traverse, along
+ * with how much their time changed since the previous run.
+ * @param previous The output directory of the previous run, if any.
+ * @param count How many units to print.
+ */
+void printSlowestUnits(const string& previous, int count){
+  map<string, UnitTimes::Entry> current = UnitTimes::getEntries();
+  if ( count <= 0 || current.empty() ) return;
+
+  map<string, UnitTimes::Entry> before;
+  bool compared = !previous.empty() && UnitTimes::load(previous + "/" + UNIT_TIMES_FILENAME, before);
+
+  cout << endl << "Slowest translation units";
+  if ( compared ) cout << " (change since " << previous << ")";
+  cout << ":" << endl;
+
+  ios::fmtflags flags = cout.flags();
+  cout << fixed << setprecision(3);
+  for ( auto& unit : UnitTimes::slowest(current, count) ){
+    const UnitTimes::Entry& entry = unit.second;
+    cout << "  " << setw(9) << entry.total() << "s  (parse " << entry.parse << "s, traversal "
+         << entry.traversal << "s, " << entry.nodes << " nodes, " << entry.edges << " edges)";
+
+    if ( compared ){
+      auto old = before.find(unit.first);
+      if ( old == before.end() ) cout << "  new";
+      else cout << "  " << showpos << entry.total() - old->second.total() << "s" << noshowpos;
+    }
+    cout << "  " << unit.first << endl;
+  }
+  cout.flags(flags);
+  cout << endl;
+}
+
 /**
  * Driver method for the ADD command.
  * Allows users to specify files and folders to add.
@@ -161,6 +323,48 @@ void printHeader(){
 }
 
 
+/**
+ * Runs the exception-flow queries given on the command line.
+ * @param vm The parsed command line arguments.
+ */
+void runQueries(po::variables_map& vm){
+    if (vm.count("escapes")){
+        for (string function : vm["escapes"].as<vector<string>>()){
+            vector<ZeldaNode*> results = ParentWalker::queryEscapes(function);
+            cout << "Exceptions escaping " << function << ": " << results.size() << endl;
+            for (ZeldaNode* node : results){
+                cout << "  " << node->getID() << " (" << node->getSingleAttribute("type") << ")" << endl;
+            }
+        }
+    }
+
+    if (vm.count("lands")){
+        for (string throwID : vm["lands"].as<vector<string>>()){
+            vector<ZeldaNode*> results = ParentWalker::queryDestinations(throwID);
+            cout << "Destinations of " << throwID << ": " << results.size() << endl;
+            for (ZeldaNode* node : results){
+                string kind = (node->getType() == ZeldaNode::CATCH) ? "caught by " : "escapes ";
+                cout << "  " << kind << node->getName() << endl;
+            }
+        }
+    }
+
+    if (vm.count("query")){
+        for (string expression : vm["query"].as<vector<string>>()){
+            vector<pair<string, string>> results;
+            string error;
+            if (!ParentWalker::queryRelation(expression, results, error)){
+                cerr << "Query " << expression << " failed: " << error << endl;
+                continue;
+            }
+            cout << "Results of " << expression << ": " << results.size() << endl;
+            for (auto& tuple : results){
+                cout << "  " << tuple.first << " " << tuple.second << endl;
+            }
+        }
+    }
+}
+
 /**
  * Main method that drives the program. Prints the
  * header and then determines what mode to be in.
@@ -172,22 +376,67 @@ int main(int argc, const char** argv) {
     ZeldaHandler local;
     masterHandle = &local;
 
-    bool simpleMode = argc != 1;
+    po::options_description desc("Options");
+    desc.add_options()
+            ("help,h", "Prints this help message.")
+            ("lazy", "Skips whole-program exception propagation. Flow is only computed for queries.")
+            ("escapes", po::value<vector<string>>(), "Lists the exceptions that can escape a function (ID or name).")
+            ("lands", po::value<vector<string>>(), "Lists where a throw (ID) is caught or escapes.")
+            ("query", po::value<vector<string>>(), "Evaluates a relational query over the graph (e.g. \"call+ o throws\").")
+            ("changed", po::value<string>(), "Only analyzes the units affected by a git revision range (e.g. main..HEAD).")
+            ("serve", po::value<string>(), "Keeps the model in memory and answers queries on a Unix socket.")
+            ("watch", po::value<string>(), "Keeps running and updates the outputs whenever files in a directory change.")
+            ("stats", "Writes the time and peak memory of each phase to stats.json in the output directory.")
+            ("trace", po::value<string>(), "Writes a Chrome trace of the run, including Clang's own time trace, to a JSON file.")
+            ("jobs,j", po::value<int>(), "How many translation units are walked at once, longest first, and how many threads propagate exceptions (0 uses every core).")
+            ("slowest", po::value<int>()->default_value(DEFAULT_SLOWEST), "How many of the slowest translation units to report (0 to skip).")
+            ("paths", po::value<vector<string>>(), "The files and directories to analyze.");
+    po::positional_options_description positional;
+    positional.add("paths", -1);
 
-    if ( argc == 1 ){
+    po::variables_map vm;
+    try {
+        po::store(po::command_line_parser(argc, argv).options(desc).positional(positional).run(), vm);
+        po::notify(vm);
+    } catch (po::error& e){
+        cerr << "Error: " << e.what() << endl << desc << endl;
+        return 1;
+    }
+
+    if (vm.count("help")){
+        cout << desc << endl;
+        return 0;
+    }
+    if (!vm.count("paths") && !vm.count("watch")){
       cerr << "Must include at least one file to analyze." << endl;
       return 1;
     }
+    if (vm.count("serve") && vm.count("watch")){
+      cerr << "Error: --serve and --watch cannot be used together." << endl;
+      return 1;
+    }
+    ParentWalker::setLazyMode(vm.count("lazy") > 0);
+    if (vm.count("jobs")){
+      masterHandle->setJobs(vm["jobs"].as<int>());
+      ParentWalker::setNumThreads(vm["jobs"].as<int>());
+    }
+    PhaseStats::setEnabled(vm.count("stats") > 0);
+    if (vm.count("trace")) TraceLog::begin(vm["trace"].as<string>());
+
+    //A watched directory is analyzed when nothing else is given.
+    vector<string> paths;
+    if (vm.count("paths")) paths = vm["paths"].as<vector<string>>();
+    else paths.push_back(vm["watch"].as<string>());
 
     //Print the header first.
     printHeader();
 
     // runs the necessary steps for analysis
     vector<path> dirs;
+    PhaseStats::Timer discovery("discovery");
     
     // determines files from args
-    for ( int i = 1; i < argc; ++i ){
-      string path = argv[i];
+    for ( string path : paths ){
       //cout << path << endl;
       addFiles(path);
       if ( is_directory(path) ){
@@ -195,6 +444,12 @@ int main(int argc, const char** argv) {
       }
     }
 
+    if (vm.count("changed")) selectImpactedUnits(vm["changed"].as<string>(), dirs[0]);
+    discovery.stop();
+
+    //The previous run's timings let the longest units start first.
+    string previousDir = findPreviousOutputDir(dirs[0]);
+    if (!previousDir.empty()) masterHandle->loadUnitHistory(previousDir + "/" + UNIT_TIMES_FILENAME);
     string outputDir = setupOutputDir(dirs[0]);
     
     cout << "Processing file(s)..." << endl << "This may take some time!" << endl << endl;
@@ -212,7 +467,31 @@ int main(int argc, const char** argv) {
     } else {
         cerr << "There was an error resolving components in the models." << endl;
     }
+    runQueries(vm);
+
     path out = outputDir; 
     outputGraphs(out);
+    printSlowestUnits(previousDir, vm["slowest"].as<int>());
+    MemoryReport memory;
+    if (PhaseStats::isEnabled() && ParentWalker::reportMemory(memory)) PhaseStats::setSection("graphMemory", memory.toJson());
+    if (PhaseStats::isEnabled()) PhaseStats::setSection("lockWaits", LockWaits::toJson());
+#ifdef ZELDA_VISIT_STATS
+    if (PhaseStats::isEnabled()) PhaseStats::setSection("visitors", VisitStats::toJson());
+#endif
+    if (PhaseStats::isEnabled() && !PhaseStats::save(outputDir + "/" + STATS_FILENAME)){
+        cerr << "Error writing to " << outputDir << "/" << STATS_FILENAME << "!" << endl;
+    }
+    if (TraceLog::isEnabled() && !TraceLog::save()){
+        cerr << "Error writing the trace to " << vm["trace"].as<string>() << "!" << endl;
+    }
+
+    if (vm.count("serve")){
+      ZeldaServer server(vm["serve"].as<string>());
+      return server.serve() ? 0 : 1;
+    }
+    if (vm.count("watch")){
+      ZeldaWatcher watcher(masterHandle, path(vm["watch"].as<string>()));
+      return watcher.watch(outputDir) ? 0 : 1;
+    }
     return 0;
 }
@@ -0,0 +1,209 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ZeldaServer.cpp
+//
+// Keeps the merged graph in memory after a run and answers
+// queries about it over a local Unix domain socket. Each
+// request is one line; each answer ends with an empty line.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include "ZeldaServer.h"
+#include "../Walker/ParentWalker.h"
+
+using namespace std;
+
+static const string HELP =
+        "neighbors <node> [<edge type>|all] [out|in]\n"
+        "escapes <function>\n"
+        "lands <throw>\n"
+        "path <throw> <catch or function>\n"
+        "reach <node> <node>\n"
+        "catchable <throw or function> <catch>\n"
+        "query <relational expression>\n"
+        "memory\n"
+        "help\n"
+        "shutdown\n";
+
+/**
+ * Constructor that prepares the server.
+ * @param socketPath Where to create the socket.
+ */
+ZeldaServer::ZeldaServer(string socketPath) : socketPath(socketPath), fd(-1) { }
+
+/** Closes and removes the socket. */
+ZeldaServer::~ZeldaServer(){
+  if ( fd < 0 ) return;
+  close(fd);
+  unlink(socketPath.c_str());
+}
+
+/**
+ * Accepts clients one at a time until one asks for a shutdown.
+ * @return False if the socket could not be created.
+ */
+bool ZeldaServer::serve(){
+  sockaddr_un address;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if ( socketPath.size() >= sizeof(address.sun_path) ){
+    cerr << "Error: The socket path " << socketPath << " is too long." << endl;
+    return false;
+  }
+  strcpy(address.sun_path, socketPath.c_str());
+
+  fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if ( fd < 0 ){
+    cerr << "Error: Could not create a socket: " << strerror(errno) << endl;
+    return false;
+  }
+
+  //Only the current user may query the model.
+  unlink(socketPath.c_str());
+  mode_t mask = umask(0077);
+  int bound = ::bind(fd, (sockaddr*) &address, sizeof(address));
+  umask(mask);
+  if ( bound < 0 || listen(fd, 8) < 0 ){
+    cerr << "Error: Could not listen on " << socketPath << ": " << strerror(errno) << endl;
+    return false;
+  }
+  cout << "Serving queries on " << socketPath << "..." << endl;
+
+  while ( true ){
+    int client = accept(fd, nullptr, nullptr);
+    if ( client < 0 ){
+      if ( errno == EINTR ) continue;
+      cerr << "Error: Could not accept a client: " << strerror(errno) << endl;
+      return false;
+    }
+    bool keepGoing = handleClient(client);
+    close(client);
+    if ( !keepGoing ) return true;
+  }
+}
+
+/**
+ * Answers the requests of one client until it disconnects.
+ * @param client The client socket.
+ * @return False if the client asked for a shutdown.
+ */
+bool ZeldaServer::handleClient(int client){
+  string pending;
+  char buffer[4096];
+  while ( true ){
+    ssize_t length = read(client, buffer, sizeof(buffer));
+    if ( length < 0 && errno == EINTR ) continue;
+    if ( length <= 0 ) return true;
+    pending.append(buffer, length);
+
+    size_t end;
+    while ( (end = pending.find('\n')) != string::npos ){
+      string request = pending.substr(0, end);
+      pending.erase(0, end + 1);
+      if ( !request.empty() && request.back() == '\r' ) request.pop_back();
+
+      ostringstream out;
+      bool keepGoing = answer(request, out);
+      out << "\n";
+      if ( !sendAll(client, out.str()) || !keepGoing ) return keepGoing;
+    }
+  }
+}
+
+/**
+ * Answers a single request.
+ * @param request The request line.
+ * @param out Receives the answer, one result per line.
+ * @return False if the request asked for a shutdown.
+ */
+bool ZeldaServer::answer(const string& request, ostream& out){
+  istringstream in(request);
+  vector<string> words;
+  for ( string word; in >> word; ) words.push_back(word);
+  if ( words.empty() ) return true;
+
+  string command = words[0];
+  if ( command == "neighbors" && words.size() >= 2 && words.size() <= 4 ){
+    string type = ( words.size() >= 3 ) ? words[2] : "all";
+    bool outgoing = words.size() < 4 || words[3] == "out";
+    if ( words.size() == 4 && words[3] != "out" && words[3] != "in" ){
+      out << "ERROR direction must be out or in\n";
+      return true;
+    }
+    for ( auto edge : ParentWalker::queryNeighbors(words[1], type, outgoing) ){
+      out << ZeldaEdge::typeToString(edge->getType()) << " " << edge->getSourceID() << " "
+          << edge->getDestinationID() << "\n";
+    }
+  } else if ( command == "escapes" && words.size() == 2 ){
+    for ( auto node : ParentWalker::queryEscapes(words[1]) ){
+      out << node->getID() << " " << node->getSingleAttribute("type") << "\n";
+    }
+  } else if ( command == "lands" && words.size() == 2 ){
+    for ( auto node : ParentWalker::queryDestinations(words[1]) ){
+      string kind = ( node->getType() == ZeldaNode::CATCH ) ? "caught " : "escapes ";
+      out << kind << node->getID() << "\n";
+    }
+  } else if ( command == "path" && words.size() == 3 ){
+    for ( auto node : ParentWalker::queryPath(words[1], words[2]) ){
+      out << ZeldaNode::typeToString(node->getType()) << " " << node->getID() << "\n";
+    }
+  } else if ( ( command == "reach" || command == "catchable" ) && words.size() == 3 ){
+    int reached = ParentWalker::queryReach(words[1], words[2], command == "catchable");
+    if ( reached < 0 ) out << "ERROR unknown node\n";
+    else out << ( ( reached ) ? "yes" : "no" ) << "\n";
+  } else if ( command == "query" && words.size() >= 2 ){
+    vector<pair<string, string>> result;
+    string error;
+    if ( !ParentWalker::queryRelation(request.substr(request.find("query") + 5), result, error) ){
+      out << "ERROR " << error << "\n";
+      return true;
+    }
+    for ( auto& tuple : result ) out << tuple.first << " " << tuple.second << "\n";
+  } else if ( command == "memory" && words.size() == 1 ){
+    MemoryReport report;
+    if ( !ParentWalker::reportMemory(report) ) out << "ERROR no graph has been built\n";
+    else out << report.toString();
+  } else if ( command == "help" ){
+    out << HELP;
+  } else if ( command == "shutdown" ){
+    return false;
+  } else {
+    out << "ERROR unknown request, try help\n";
+  }
+  return true;
+}
+
+/**
+ * Writes a whole answer to a client.
+ * @param client The client socket.
+ * @param data The answer.
+ * @return Whether the client received it.
+ */
+bool ZeldaServer::sendAll(int client, const string& data){
+  size_t sent = 0;
+  while ( sent < data.size() ){
+    ssize_t length = send(client, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+    if ( length < 0 && errno == EINTR ) continue;
+    if ( length <= 0 ) return false;
+    sent += length;
+  }
+  return true;
+}
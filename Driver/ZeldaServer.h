@@ -0,0 +1,51 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ZeldaServer.h
+//
+// Keeps the merged graph in memory after a run and answers
+// queries about it over a local Unix domain socket. Each
+// request is one line; each answer ends with an empty line.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef ZELDA_ZELDASERVER_H
+#define ZELDA_ZELDASERVER_H
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+class ZeldaServer {
+public:
+    /** Constructors/Destructors */
+    explicit ZeldaServer(std::string socketPath);
+    ~ZeldaServer();
+
+    /** Serve Loop */
+    bool serve();
+
+    /** Request Handling */
+    static bool answer(const std::string& request, std::ostream& out);
+
+private:
+    /** Member Variables */
+    std::string socketPath;
+    int fd;
+
+    /** Connection Helpers */
+    bool handleClient(int client);
+    static bool sendAll(int client, const std::string& data);
+};
+
+#endif //ZELDA_ZELDASERVER_H
@@ -0,0 +1,135 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ZeldaWatcher.cpp
+//
+// Watches a source tree with inotify and patches the
+// resident graph whenever sources or headers are saved,
+// rewriting the outputs after every change.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <iostream>
+#include <vector>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#include "ZeldaWatcher.h"
+#include "../Walker/ParentWalker.h"
+
+using namespace std;
+
+static const uint32_t FILE_EVENTS = IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE;
+static const uint32_t DIR_EVENTS = IN_CREATE | IN_MOVED_TO;
+
+/**
+ * Constructor that prepares the watcher.
+ * @param handler The handler holding the resident graph.
+ * @param root The directory to watch.
+ */
+ZeldaWatcher::ZeldaWatcher(ZeldaHandler* handler, path root) : handler(handler), root(root) {
+  fd = inotify_init1(IN_CLOEXEC);
+}
+
+/** Closes the inotify instance. */
+ZeldaWatcher::~ZeldaWatcher(){
+  if ( fd >= 0 ) close(fd);
+}
+
+/**
+ * Watches the tree until the process is stopped. Changes arriving
+ * close together are patched in one go.
+ * @param outputDir The directory the outputs are rewritten to.
+ * @return False if the tree could not be watched.
+ */
+bool ZeldaWatcher::watch(string outputDir){
+  if ( fd < 0 ){
+    cerr << "Error: inotify is not available, cannot watch " << root << "." << endl;
+    return false;
+  }
+  addWatches(root);
+  cout << "Watching " << root << " for changes..." << endl;
+
+  while ( true ){
+    set<string> changed;
+    if ( !readChanges(-1, changed) ) return false;
+
+    //Let the editor finish writing before anything is walked.
+    while ( readChanges(SETTLE_TIME, changed) ) {}
+    if ( changed.empty() ) continue;
+
+    vector<path> paths;
+    for ( auto file : changed ){
+      cout << "Changed: " << file << endl;
+      paths.emplace_back(file);
+    }
+
+    bool success = handler->patchFiles(paths);
+    if ( !success ) cerr << "Warning: Compilation errors were detected." << endl;
+    handler->outputModel(outputDir);
+    cout << "Outputs updated in " << outputDir << "." << endl;
+  }
+}
+
+/**
+ * Watches a directory and everything below it.
+ * @param directory The directory to watch.
+ */
+void ZeldaWatcher::addWatches(path directory){
+  int wd = inotify_add_watch(fd, directory.c_str(), FILE_EVENTS | DIR_EVENTS | IN_ONLYDIR);
+  if ( wd < 0 ) return;
+  directories[wd] = directory;
+
+  directory_iterator endIter;
+  for ( directory_iterator iter(directory); iter != endIter; iter++ ){
+    if ( is_directory(iter->path()) && !is_symlink(iter->path()) ) addWatches(iter->path());
+  }
+}
+
+/**
+ * Reads the pending inotify events.
+ * @param timeout How long to wait for an event in milliseconds, or -1 to block.
+ * @param changed Collects the sources and headers that changed.
+ * @return Whether any event arrived before the timeout.
+ */
+bool ZeldaWatcher::readChanges(int timeout, set<string>& changed){
+  pollfd request = { fd, POLLIN, 0 };
+  if ( poll(&request, 1, timeout) <= 0 ) return false;
+
+  alignas(inotify_event) char buffer[4096];
+  ssize_t length = read(fd, buffer, sizeof(buffer));
+  if ( length <= 0 ) return false;
+
+  for ( char* cur = buffer; cur < buffer + length; ){
+    const inotify_event* event = (const inotify_event*) cur;
+    cur += sizeof(inotify_event) + event->len;
+
+    if ( event->mask & IN_IGNORED ){
+      directories.erase(event->wd);
+      continue;
+    }
+    auto dir = directories.find(event->wd);
+    if ( dir == directories.end() || event->len == 0 ) continue;
+    path file = dir->second / event->name;
+
+    //New directories are watched as they appear.
+    if ( event->mask & IN_ISDIR ){
+      if ( event->mask & DIR_EVENTS ) addWatches(file);
+      continue;
+    }
+    if ( (event->mask & FILE_EVENTS) && ParentWalker::isCFile(file.string()) ){
+      changed.insert(file.string());
+    }
+  }
+  return true;
+}
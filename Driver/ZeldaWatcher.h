@@ -0,0 +1,55 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ZeldaWatcher.h
+//
+// Watches a source tree with inotify and patches the
+// resident graph whenever sources or headers are saved,
+// rewriting the outputs after every change.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef ZELDA_ZELDAWATCHER_H
+#define ZELDA_ZELDAWATCHER_H
+
+#include <map>
+#include <set>
+#include <string>
+#include <boost/filesystem.hpp>
+#include "ZeldaHandler.h"
+
+class ZeldaWatcher {
+public:
+    /** Constructors/Destructors */
+    ZeldaWatcher(ZeldaHandler* handler, path root);
+    ~ZeldaWatcher();
+
+    /** Watch Loop */
+    bool watch(std::string outputDir);
+
+private:
+    /** Time to wait for an editor to finish saving, in milliseconds */
+    const int SETTLE_TIME = 200;
+
+    /** Member Variables */
+    ZeldaHandler* handler;
+    path root;
+    int fd;
+    std::map<int, path> directories;
+
+    /** Watch Helpers */
+    void addWatches(path directory);
+    bool readChanges(int timeout, std::set<std::string>& changed);
+};
+
+#endif //ZELDA_ZELDAWATCHER_H
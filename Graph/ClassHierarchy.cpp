@@ -0,0 +1,134 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ClassHierarchy.cpp
+//
+// Class hierarchy table built from the CLASS nodes and
+// INHERITS edges of a graph. Classes are keyed by the ID
+// generated from their canonical record declaration and
+// each class keeps a bitset of all of its direct and
+// indirect bases so subtype checks are a single lookup.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include "ClassHierarchy.h"
+
+using namespace std;
+
+/**
+ * Builds the table from the classes in a graph.
+ * @param graph The graph holding CLASS nodes and INHERITS edges.
+ */
+ClassHierarchy::ClassHierarchy(TAGraph* graph){
+    classes = graph->findNodesByType(ZeldaNode::CLASS);
+    sort(classes.begin(), classes.end(), [](ZeldaNode* first, ZeldaNode* second) -> bool {
+        return first->getID() < second->getID();
+    });
+
+    unordered_map<ZeldaNode*, int> nodeIndex;
+    for (int i = 0; i < classes.size(); i++){
+        nodeIndex[classes[i]] = i;
+        idIndex[classes[i]->getID()] = i;
+        if (nameIndex.find(classes[i]->getName()) == nameIndex.end()) nameIndex[classes[i]->getName()] = i;
+    }
+
+    //INHERITS edges run from the base class to the derived class.
+    bases.resize(classes.size());
+    for (int i = 0; i < classes.size(); i++){
+        for (ZeldaEdge* edge : graph->findEdgesByTypeAndSrc(classes[i], ZeldaEdge::INHERITS)){
+            auto it = nodeIndex.find(edge->getDestination());
+            if (it == nodeIndex.end()) continue;
+            bases[it->second].push_back(i);
+        }
+    }
+
+    ancestors.resize(classes.size());
+    closed.assign(classes.size(), false);
+}
+
+/**
+ * Destructor.
+ */
+ClassHierarchy::~ClassHierarchy(){ }
+
+/**
+ * Finds a class by its generated ID or, failing that, by its name.
+ * @param key The class ID or the cleaned type name.
+ * @return The class index, or -1.
+ */
+int ClassHierarchy::findClass(const string& key){
+    auto it = idIndex.find(key);
+    if (it != idIndex.end()) return it->second;
+
+    it = nameIndex.find(key);
+    if (it != nameIndex.end()) return it->second;
+    return -1;
+}
+
+/**
+ * Gets the number of classes.
+ * @return The number of classes in the table.
+ */
+int ClassHierarchy::getNumClasses(){
+    return (int) classes.size();
+}
+
+/**
+ * Gets a class node by index.
+ * @param index The class index.
+ * @return The class node.
+ */
+ZeldaNode* ClassHierarchy::getClass(int index){
+    return classes.at(index);
+}
+
+/**
+ * Checks whether one class derives from another.
+ * @param derived The derived class index.
+ * @param base The base class index.
+ * @return Whether derived is base or inherits from it, directly or not.
+ */
+bool ClassHierarchy::isSubclass(int derived, int base){
+    if (derived < 0 || base < 0) return false;
+    if (derived == base) return true;
+    return getAncestors(derived).test(base);
+}
+
+/**
+ * Gets every direct and indirect base of a class.
+ * @param index The class index.
+ * @return The set of ancestor class indices.
+ */
+const ExceptionSet& ClassHierarchy::getAncestors(int index){
+    if (closed[index]) return ancestors[index];
+
+    //Walk the bases once; a class already in the set is not revisited.
+    ExceptionSet& result = ancestors[index];
+    vector<int> stack = bases[index];
+    while (!stack.empty()){
+        int cur = stack.back();
+        stack.pop_back();
+        if (cur == index || result.test(cur)) continue;
+        result.set(cur);
+
+        if (closed[cur]){
+            result.unite(ancestors[cur]);
+            continue;
+        }
+        stack.insert(stack.end(), bases[cur].begin(), bases[cur].end());
+    }
+
+    closed[index] = true;
+    return result;
+}
@@ -0,0 +1,59 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ClassHierarchy.h
+//
+// Class hierarchy table built from the CLASS nodes and
+// INHERITS edges of a graph. Classes are keyed by the ID
+// generated from their canonical record declaration and
+// each class keeps a bitset of all of its direct and
+// indirect bases so subtype checks are a single lookup.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef ZELDA_CLASSHIERARCHY_H
+#define ZELDA_CLASSHIERARCHY_H
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "TAGraph.h"
+#include "ExceptionSet.h"
+
+class ClassHierarchy {
+public:
+    //Constructor/Destructor
+    explicit ClassHierarchy(TAGraph* graph);
+    ~ClassHierarchy();
+
+    //Lookup Methods
+    int findClass(const std::string& key);
+    int getNumClasses();
+    ZeldaNode* getClass(int index);
+
+    //Subtype Methods
+    bool isSubclass(int derived, int base);
+    const ExceptionSet& getAncestors(int index);
+
+private:
+    std::vector<ZeldaNode*> classes;
+    std::unordered_map<std::string, int> idIndex;
+    std::unordered_map<std::string, int> nameIndex;
+    std::vector<std::vector<int>> bases;
+
+    //Closures are filled in the first time a class is asked about.
+    std::vector<ExceptionSet> ancestors;
+    std::vector<bool> closed;
+};
+
+#endif //ZELDA_CLASSHIERARCHY_H
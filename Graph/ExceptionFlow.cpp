@@ -0,0 +1,1442 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ExceptionFlow.cpp
+//
+// Summary-based exception propagation for Zelda.
+// Functions, try blocks and catch blocks are treated
+// as scopes. The scope graph is condensed into strongly
+// connected components and each scope's escaping
+// exceptions are computed bottom-up to a fixpoint
+// before any THROWS, CATCHES or FUNC_THROWS edges are
+// written back to the graph. Independent components
+// and the write-back of separate scopes are spread over
+// a thread pool; writes are buffered per worker, sharded
+// by source, throw and file, and each shard is committed
+// by one worker in scope order so output is deterministic.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include "ExceptionFlow.h"
+#include "PhaseStats.h"
+
+using namespace std;
+
+static const string TYPE_FLAG = "type";
+static const string TYPE_CLASS_FLAG = "typeClass";
+static const string FILENAME_FLAG = "filename";
+static const string CATCH_ALL = "all";
+
+//Names and kinds of the attributes written to throws, by AttributeKey.
+enum AttributeKind {MULTI, SINGLE, COUNT, FLAG};
+static const string ATTRIBUTE_NAMES[] = {"seenBy", "path", "functions", "funcCount", "function", "intermodual",
+                                         "intermodualCatch", "caughtBy"};
+static const AttributeKind ATTRIBUTE_KINDS[] = {MULTI, MULTI, MULTI, COUNT, SINGLE, FLAG, FLAG, MULTI};
+
+/**
+ * Orders nodes by ID so scope and throw numbering is stable between runs.
+ * @param first The first node.
+ * @param second The second node.
+ * @return Whether the first node sorts before the second.
+ */
+static bool compareNodes(ZeldaNode* first, ZeldaNode* second){
+    return first->getID() < second->getID();
+}
+
+/**
+ * Strips qualifiers and references from a type name.
+ * @param s The type name to clean.
+ */
+static void cleanType(string &s){
+  bool cont = true;
+  while ( cont ){
+    if ( s.length() > 6 && s.substr(0,6) == "const " ){
+      s = s.substr(6);
+    }
+    else if ( s.length() > 2 && s.substr(s.length()-2) == " &" ){
+      s = s.substr(0,s.length()-2);
+    }
+    else {
+      cont = false;
+    }
+  }
+}
+
+/**
+ * Constructor.
+ * @param graph The graph to propagate exceptions through.
+ * @param workers The number of threads to use. Zero uses every core.
+ */
+ExceptionFlow::ExceptionFlow(TAGraph* graph, int workers) : graph(graph), hierarchy(graph), prepared(false), materialized(false), workers(workers), pool(nullptr) { }
+
+/**
+ * Destructor.
+ */
+ExceptionFlow::~ExceptionFlow(){ }
+
+/**
+ * Propagates every throw in the graph to its handlers.
+ */
+void ExceptionFlow::run(){
+    ThreadPool threads(workers);
+    pool = &threads;
+
+    PhaseStats::Timer scopeTimer("exception scopes");
+    prepare();
+    scopeTimer.stop();
+    PhaseStats::Timer summaryTimer("exception summaries");
+    summarize();
+    summaryTimer.stop();
+    PhaseStats::Timer writeTimer("exception write-back");
+    materialize();
+    writeTimer.stop();
+    recordIDs();
+    materialized = true;
+
+    pool = nullptr;
+}
+
+/**
+ * Recomputes exception flow after some functions changed. Only the
+ * components containing changed scopes and everything that depends on
+ * them are summarized again; their derived edges are removed and
+ * rewritten, and the attributes of the throws they carry are rebuilt.
+ * Class hierarchy changes are not tracked and need a full run.
+ * @param changed The function nodes whose bodies changed or were added.
+ */
+void ExceptionFlow::update(const vector<ZeldaNode*>& changed){
+    if (!materialized){
+        reset();
+        return;
+    }
+
+    ThreadPool threads(workers);
+    pool = &threads;
+
+    //Keep the previous flow. Nodes may be gone, so it is matched by ID.
+    vector<Scope> old;
+    old.swap(scopes);
+    vector<vector<int>> oldUsers;
+    oldUsers.swap(users);
+    vector<int> oldOrigins = originScope;
+    vector<string> oldScopeIDs = scopeIDs;
+    vector<string> oldThrowIDs = throwIDs;
+
+    reset();
+    prepare();
+
+    unordered_map<string, int> scopeByID;
+    for (int i = 0; i < scopes.size(); i++) scopeByID[scopes[i].node->getID()] = i;
+    unordered_map<string, int> throwByID;
+    for (int i = 0; i < throws.size(); i++) throwByID[throws[i]->getID()] = i;
+
+    vector<int> oldToNew(old.size(), -1);
+    vector<int> newToOld(scopes.size(), -1);
+    for (int i = 0; i < old.size(); i++){
+        auto it = scopeByID.find(oldScopeIDs[i]);
+        if (it == scopeByID.end()) continue;
+        oldToNew[i] = it->second;
+        newToOld[it->second] = i;
+    }
+    vector<int> throwMap(oldThrowIDs.size(), -1);
+    for (int i = 0; i < oldThrowIDs.size(); i++){
+        auto it = throwByID.find(oldThrowIDs[i]);
+        if (it != throwByID.end()) throwMap[i] = it->second;
+    }
+
+    //Dirty scopes: new ones, changed functions and everything inside them.
+    unordered_map<ZeldaNode*, bool> changedNodes;
+    for (ZeldaNode* node : changed) changedNodes[node] = true;
+    vector<int> dirty;
+    for (int i = 0; i < scopes.size(); i++){
+        int function = enclosingFunction(i);
+        bool inChanged = function != -1 && changedNodes.count(scopes[function].node);
+        if (newToOld[i] == -1 || inChanged) dirty.push_back(i);
+    }
+
+    //Old scopes that lost a dependency are dirty too.
+    vector<int> oldDirty;
+    for (int i = 0; i < old.size(); i++){
+        if (oldToNew[i] == -1) oldDirty.push_back(i);
+    }
+    for (int i : dirty){
+        if (newToOld[i] != -1) oldDirty.push_back(newToOld[i]);
+    }
+    vector<char> oldAffected = closure(old, oldUsers, oldDirty);
+    for (int i = 0; i < old.size(); i++){
+        if (oldAffected[i] && oldToNew[i] != -1) dirty.push_back(oldToNew[i]);
+    }
+    vector<char> affected = closure(scopes, users, dirty);
+
+    //Untouched components keep their previous summaries. A catch's caught
+    //set belongs to its try, so it is kept whenever the try is untouched.
+    for (int i = 0; i < scopes.size(); i++){
+        int owner = scopes[i].owner;
+        if (affected[i] && (owner == -1 || affected[owner] || newToOld[i] == -1)) continue;
+        const Scope& prev = old[newToOld[i]];
+        scopes[i].caught = remap(prev.caught, throwMap);
+        if (affected[i]) continue;
+        scopes[i].in = remap(prev.in, throwMap);
+        scopes[i].esc = remap(prev.esc, throwMap);
+    }
+    for (int i = 0; i < components.size(); i++){
+        summarized[i] = !affected[components[i][0]];
+    }
+    summarize();
+
+    //Throws carried by an affected scope before or after the change.
+    ExceptionSet affectedThrows;
+    for (int i = 0; i < old.size(); i++){
+        if (oldAffected[i] || (oldToNew[i] != -1 && affected[oldToNew[i]])){
+            affectedThrows.unite(remap(old[i].in, throwMap));
+            removeDerived(old, i, oldOrigins, throwByID);
+        }
+    }
+    for (int i = 0; i < scopes.size(); i++){
+        if (!affected[i]) continue;
+        affectedThrows.unite(scopes[i].in);
+        if (scopes[i].type == ZeldaNode::FUNCTION) scopes[i].node->removeAttribute("isRecursive");
+    }
+    for (int thrown = affectedThrows.next(0); thrown != -1; thrown = affectedThrows.next(thrown + 1)){
+        resetThrow(throws[thrown]);
+    }
+
+    writeBack(affected, affectedThrows);
+    recordIDs();
+    pool = nullptr;
+}
+
+/**
+ * Builds the scope graph and its components without computing any
+ * summaries. Queries call this on their own; summaries are then only
+ * computed for the part of the graph a query reaches.
+ */
+void ExceptionFlow::prepare(){
+    if (prepared) return;
+    buildScopes();
+    condense();
+    prepareMasks();
+
+    users.resize(scopes.size());
+    for (int i = 0; i < scopes.size(); i++){
+        for (int feed : scopes[i].feeds) users[feed].push_back(i);
+    }
+    summarized.assign(components.size(), false);
+    prepared = true;
+}
+
+/**
+ * Gets the exceptions that can escape a function. Only the components
+ * the function depends on are summarized, and summaries are kept for
+ * later queries.
+ * @param function The function node.
+ * @return The throw nodes that can escape it, ordered by ID.
+ */
+vector<ZeldaNode*> ExceptionFlow::queryEscapes(ZeldaNode* function){
+    prepare();
+    vector<ZeldaNode*> result;
+    auto it = scopeIndex.find(function);
+    if (it == scopeIndex.end()) return result;
+
+    summarizeSlice(scopes[it->second].component);
+    const ExceptionSet& esc = escapes(it->second);
+    for (int thrown = esc.next(0); thrown != -1; thrown = esc.next(thrown + 1)){
+        result.push_back(throws[thrown]);
+    }
+    sort(result.begin(), result.end(), compareNodes);
+    return result;
+}
+
+/**
+ * Gets where a throw ends up: the catches that handle it and the
+ * functions without callers it escapes from. The throw is followed
+ * forward on its own, so no summaries are needed.
+ * @param throwNode The throw node.
+ * @return The catch and function nodes, ordered by ID.
+ */
+vector<ZeldaNode*> ExceptionFlow::queryDestinations(ZeldaNode* throwNode){
+    prepare();
+    vector<ZeldaNode*> result;
+
+    //Throws resolved with their translation unit already have their catches.
+    if (throwNode->isResolved()){
+        for (ZeldaEdge* edge : graph->findEdgesByTypeAndDst(throwNode, ZeldaEdge::CATCHES)){
+            if (edge->getSource()) result.push_back(edge->getSource());
+        }
+        sort(result.begin(), result.end(), compareNodes);
+        return result;
+    }
+
+    auto it = throwIndex.find(throwNode);
+    if (it == throwIndex.end() || originScope[it->second] == -1) return result;
+    int thrown = it->second;
+
+    auto memo = destinationMemo.find(thrown);
+    if (memo != destinationMemo.end()) return memo->second;
+
+    vector<bool> reached(scopes.size(), false);
+    vector<int> stack = {originScope[thrown]};
+    reached[originScope[thrown]] = true;
+    while (!stack.empty()){
+        int cur = stack.back();
+        stack.pop_back();
+        vector<int> next;
+
+        if (scopes[cur].node->getType() == ZeldaNode::TRY){
+            int handler = -1;
+            for (int candidate : scopes[cur].handlers){
+                if (!catchMask(scopes[candidate].handlerType).test(thrown)) continue;
+                handler = candidate;
+                break;
+            }
+
+            if (handler == -1){
+                next = users[cur];
+            } else {
+                result.push_back(scopes[handler].node);
+                if (scopes[handler].rethrows) next.push_back(handler);
+            }
+        } else {
+            next = users[cur];
+            if (next.empty() && scopes[cur].node->getType() == ZeldaNode::FUNCTION){
+                result.push_back(scopes[cur].node);
+            }
+        }
+
+        for (int user : next){
+            if (reached[user]) continue;
+            reached[user] = true;
+            stack.push_back(user);
+        }
+    }
+
+    sort(result.begin(), result.end(), compareNodes);
+    result.erase(unique(result.begin(), result.end()), result.end());
+    destinationMemo[thrown] = result;
+    return result;
+}
+
+/**
+ * Gets the shortest route a throw takes to one of its destinations,
+ * following the same steps as queryDestinations.
+ * @param throwNode The throw node.
+ * @param destination The catch or function the throw ends up in.
+ * @return The throw, the scopes it passes through and the destination,
+ *         or nothing if the destination is not reached.
+ */
+vector<ZeldaNode*> ExceptionFlow::queryPath(ZeldaNode* throwNode, ZeldaNode* destination){
+    prepare();
+    vector<ZeldaNode*> result;
+
+    //Throws resolved with their translation unit start from their linked scope.
+    int start = -1;
+    int thrown = -1;
+    auto it = throwIndex.find(throwNode);
+    if (it != throwIndex.end()){
+        thrown = it->second;
+        start = originScope[thrown];
+    } else if (throwNode->isResolved()){
+        auto scope = scopeIndex.find(throwNode->getScope());
+        if (scope != scopeIndex.end()) start = scope->second;
+    }
+    auto target = scopeIndex.find(destination);
+    if (start == -1 || target == scopeIndex.end()) return result;
+
+    vector<int> previous(scopes.size(), -2);
+    vector<int> queue = {start};
+    previous[start] = -1;
+    for (int pos = 0; pos < queue.size() && previous[target->second] == -2; pos++){
+        int cur = queue[pos];
+        vector<int> next;
+
+        if (scopes[cur].type == ZeldaNode::TRY){
+            int handler = -1;
+            for (int candidate : scopes[cur].handlers){
+                bool matches = (thrown != -1) ? catchMask(scopes[candidate].handlerType).test(thrown)
+                                              : candidate == target->second;
+                if (!matches) continue;
+                handler = candidate;
+                break;
+            }
+            //Only the chosen handler ends the route, unless it rethrows. A catch
+            //reached from a call or try in its body passes the exception on.
+            if (handler == -1) next = users[cur];
+            else if (scopes[handler].rethrows || handler == target->second) next.push_back(handler);
+        } else {
+            next = users[cur];
+        }
+
+        for (int user : next){
+            if (previous[user] != -2) continue;
+            previous[user] = cur;
+            queue.push_back(user);
+        }
+    }
+    if (previous[target->second] == -2) return result;
+
+    for (int cur = target->second; cur != -1; cur = previous[cur]){
+        result.push_back(scopes[cur].node);
+    }
+    result.push_back(throwNode);
+    reverse(result.begin(), result.end());
+    return result;
+}
+
+/**
+ * Measures every throw after propagation. Routes are found with the
+ * same steps as queryDestinations, one throw per task; the counts the
+ * write-back already keeps on the throw are read back directly.
+ * @return The metrics of every throw, ordered by ID.
+ */
+vector<ExceptionFlow::ThrowMetrics> ExceptionFlow::measure(){
+    vector<ThrowMetrics> result;
+    if (!materialized) return result;
+
+    ThreadPool threads(workers);
+    result.resize(throws.size());
+    vector<vector<int>> seen(threads.getNumWorkers(), vector<int>(scopes.size(), -1));
+    vector<vector<pair<int, int>>> depth(threads.getNumWorkers(), vector<pair<int, int>>(scopes.size()));
+    threads.parallelFor((int) throws.size(), [this, &result, &seen, &depth](int thrown, int worker) {
+        measureThrow(thrown, result[thrown], seen[worker], depth[worker]);
+    });
+
+    //Throws resolved with their translation unit stay inside their function.
+    for (ZeldaNode* node : graph->findNodesByType(ZeldaNode::THROW)){
+        if (!node->isResolved()) continue;
+        ThrowMetrics metrics;
+        metrics.throwNode = node;
+        metrics.frames = localFrames(node);
+        metrics.functionHops = (metrics.frames == -1) ? -1 : 0;
+        metrics.functions = 0;
+        metrics.handlers = (metrics.frames == -1) ? 0 : 1;
+        metrics.escapes = false;
+        metrics.intermodual = node->getBoolAttribute("intermodual");
+        result.push_back(metrics);
+    }
+
+    sort(result.begin(), result.end(), [](const ThrowMetrics& first, const ThrowMetrics& second) -> bool {
+        return compareNodes(first.throwNode, second.throwNode);
+    });
+    return result;
+}
+
+/**
+ * Counts the scopes a throw resolved with its translation unit leaves,
+ * following its scope links up to the handler as resolveLocal did.
+ * The derived edges are not counted, since units including the same
+ * header may each have written them.
+ * @param throwNode The resolved throw.
+ * @return The scopes up to and including the handling try, or -1 if no handler is found.
+ */
+int ExceptionFlow::localFrames(ZeldaNode* throwNode){
+    int frames = 0;
+    for (ZeldaNode* cur = throwNode->getScope(); cur; ){
+        frames++;
+        if (cur->getType() == ZeldaNode::TRY){
+            for (ZeldaNode* candidate : cur->getHandlers()){
+                if (matchesLocal(graph, throwNode, candidate) != 0) return frames;
+            }
+            cur = cur->getScope();
+        } else if (cur->getType() == ZeldaNode::CATCH){
+            cur = (cur->getOwner()) ? cur->getOwner()->getScope() : nullptr;
+        } else {
+            break;
+        }
+    }
+    return -1;
+}
+
+/**
+ * Follows one throw from its origin in breadth-first order.
+ * @param thrown The throw index.
+ * @param metrics Receives the metrics.
+ * @param seen Scratch marks, one per scope, reused between throws.
+ * @param depth Scratch scope and function counts, one per scope.
+ */
+void ExceptionFlow::measureThrow(int thrown, ThrowMetrics& metrics, vector<int>& seen,
+                                 vector<pair<int, int>>& depth){
+    ZeldaNode* throwNode = throws[thrown];
+    metrics.throwNode = throwNode;
+    metrics.frames = -1;
+    metrics.functionHops = -1;
+    metrics.functions = throwNode->getCountAttribute("funcCount");
+    metrics.handlers = 0;
+    metrics.escapes = false;
+    metrics.intermodual = throwNode->getBoolAttribute("intermodual");
+    if (originScope[thrown] == -1) return;
+
+    //Depth counts the scopes and functions left before arriving in a scope.
+    vector<int> queue = {originScope[thrown]};
+    seen[originScope[thrown]] = thrown;
+    depth[originScope[thrown]] = make_pair(0, 0);
+    for (int pos = 0; pos < queue.size(); pos++){
+        int cur = queue[pos];
+        bool isFunction = scopes[cur].type == ZeldaNode::FUNCTION;
+        pair<int, int> left = make_pair(depth[cur].first + 1, depth[cur].second + ((isFunction) ? 1 : 0));
+        bool lands = false;
+        vector<int> next;
+
+        if (scopes[cur].type == ZeldaNode::TRY){
+            int handler = -1;
+            for (int candidate : scopes[cur].handlers){
+                if (!catchMask(scopes[candidate].handlerType).test(thrown)) continue;
+                handler = candidate;
+                break;
+            }
+
+            if (handler == -1){
+                next = users[cur];
+            } else {
+                metrics.handlers++;
+                lands = true;
+                if (scopes[handler].rethrows) next.push_back(handler);
+            }
+        } else {
+            //A catch is only queued as a handler when it rethrows; otherwise the
+            //exception came from its body and moves on, as in queryDestinations.
+            next = users[cur];
+            if (next.empty() && isFunction){
+                metrics.escapes = true;
+                lands = true;
+            }
+        }
+
+        if (lands && metrics.frames == -1){
+            metrics.frames = left.first;
+            metrics.functionHops = left.second;
+        }
+        for (int user : next){
+            if (seen[user] == thrown) continue;
+            seen[user] = thrown;
+            depth[user] = left;
+            queue.push_back(user);
+        }
+    }
+}
+
+/**
+ * Collects functions, tries and catches as scopes and records
+ * how exceptions move between them.
+ */
+void ExceptionFlow::buildScopes(){
+    vector<ZeldaNode*> nodes = graph->findNodesByType(ZeldaNode::FUNCTION);
+    vector<ZeldaNode*> tries = graph->findNodesByType(ZeldaNode::TRY);
+    vector<ZeldaNode*> catches = graph->findNodesByType(ZeldaNode::CATCH);
+    nodes.insert(nodes.end(), tries.begin(), tries.end());
+    nodes.insert(nodes.end(), catches.begin(), catches.end());
+    sort(nodes.begin(), nodes.end(), compareNodes);
+
+    //Throws resolved with their translation unit are already in the graph.
+    for (ZeldaNode* node : graph->findNodesByType(ZeldaNode::THROW)){
+        if (!node->isResolved()) throws.push_back(node);
+    }
+    internTypes();
+    for (int i = 0; i < throws.size(); i++) throwIndex[throws[i]] = i;
+    origins.assign(throws.size(), nullptr);
+    originScope.assign(throws.size(), -1);
+
+    scopes.resize(nodes.size());
+    for (int i = 0; i < nodes.size(); i++){
+        Scope& scope = scopes[i];
+        scope.node = nodes[i];
+        scope.type = nodes[i]->getType();
+        scope.parent = -1;
+        scope.owner = -1;
+        scope.rethrows = false;
+        scope.handlerType = -1;
+        scope.component = -1;
+        scopeIndex[nodes[i]] = i;
+        if (nodes[i]->getType() == ZeldaNode::CATCH){
+            scope.handlerType = lookupType(typeKey(nodes[i]));
+        }
+    }
+
+    //Tries and catches carry direct links to their scope and handlers.
+    for (int i = 0; i < scopes.size(); i++){
+        ZeldaNode* node = scopes[i].node;
+        if (node->getType() != ZeldaNode::TRY) continue;
+
+        auto it = scopeIndex.find(node->getScope());
+        if (it != scopeIndex.end()){
+            scopes[i].parent = it->second;
+            scopes[it->second].feeds.push_back(i);
+        }
+        for (ZeldaNode* handler : node->getHandlers()){
+            auto cur = scopeIndex.find(handler);
+            if (cur == scopeIndex.end()) continue;
+            scopes[cur->second].owner = i;
+            scopes[i].handlers.push_back(cur->second);
+        }
+    }
+
+    //Calls feed functions into their callers; throws start in their scope.
+    for (int i = 0; i < scopes.size(); i++){
+        ZeldaNode* node = scopes[i].node;
+        for (ZeldaEdge* edge : graph->findEdgesBySrc(node->getID())){
+            ZeldaNode* dst = edge->getDestination();
+            if (!dst || edge->getSource() != node) continue;
+
+            if (edge->getType() == ZeldaEdge::CONTEXT && dst->getType() == ZeldaNode::FUNCTION){
+                auto it = scopeIndex.find(dst);
+                if (it != scopeIndex.end()) scopes[i].feeds.push_back(it->second);
+            } else if ((edge->getType() == ZeldaEdge::THROWS || edge->getType() == ZeldaEdge::THROWPATH) &&
+                       dst->getType() == ZeldaNode::THROW){
+                //A throw starts in its linked scope; other edges to it were derived.
+                auto it = throwIndex.find(dst);
+                if (it == throwIndex.end() || origins[it->second]) continue;
+                if ((dst->getScope()) ? dst->getScope() != node : edge->getType() != ZeldaEdge::THROWS) continue;
+                origins[it->second] = edge;
+                originScope[it->second] = i;
+                scopes[i].localThrows.push_back(it->second);
+            } else if (edge->getType() == ZeldaEdge::RETHROWS && dst->getType() == ZeldaNode::RETHROW){
+                scopes[i].rethrows = true;
+            }
+        }
+    }
+
+    //Exceptions escaping a catch leave through the enclosing scope of its try.
+    for (int i = 0; i < scopes.size(); i++){
+        int parent = scopes[i].parent;
+        if (parent == -1) continue;
+        for (int handler : scopes[i].handlers){
+            scopes[handler].parent = parent;
+            scopes[parent].feeds.push_back(handler);
+        }
+    }
+}
+
+/**
+ * Gets the scopes that must be summarized before a scope.
+ * @param scope The scope.
+ * @return The scopes it depends on.
+ */
+vector<int> ExceptionFlow::dependencies(int scope){
+    vector<int> deps = scopes[scope].feeds;
+    if (scopes[scope].rethrows && scopes[scope].owner != -1) deps.push_back(scopes[scope].owner);
+    return deps;
+}
+
+/**
+ * Condenses the scope graph into strongly connected components.
+ * Components are stored so that every component follows the
+ * components it depends on.
+ */
+void ExceptionFlow::condense(){
+    int count = (int) scopes.size();
+    vector<int> index(count, -1);
+    vector<int> low(count, 0);
+    vector<bool> onStack(count, false);
+    vector<int> stack;
+    int next = 0;
+
+    //Iterative Tarjan so deep call chains do not exhaust the stack.
+    vector<pair<int, int>> frames;
+    vector<vector<int>> deps(count);
+    for (int root = 0; root < count; root++){
+        if (index[root] != -1) continue;
+        frames.push_back(make_pair(root, 0));
+
+        while (!frames.empty()){
+            int cur = frames.back().first;
+            int& pos = frames.back().second;
+
+            if (pos == 0 && index[cur] == -1){
+                index[cur] = low[cur] = next++;
+                stack.push_back(cur);
+                onStack[cur] = true;
+                deps[cur] = dependencies(cur);
+            }
+
+            if (pos < deps[cur].size()){
+                int dep = deps[cur][pos++];
+                if (index[dep] == -1){
+                    frames.push_back(make_pair(dep, 0));
+                } else if (onStack[dep]){
+                    low[cur] = min(low[cur], index[dep]);
+                }
+                continue;
+            }
+
+            if (low[cur] == index[cur]){
+                vector<int> component;
+                int member;
+                do {
+                    member = stack.back();
+                    stack.pop_back();
+                    onStack[member] = false;
+                    scopes[member].component = (int) components.size();
+                    component.push_back(member);
+                } while (member != cur);
+                components.push_back(component);
+            }
+
+            frames.pop_back();
+            if (!frames.empty()){
+                int caller = frames.back().first;
+                low[caller] = min(low[caller], low[cur]);
+            }
+            deps[cur].clear();
+        }
+    }
+
+    cyclic.resize(components.size());
+    for (int i = 0; i < components.size(); i++) cyclic[i] = isCyclic(i);
+}
+
+/**
+ * Groups components into levels. A component only depends on
+ * components in earlier levels, so every level can be summarized
+ * in parallel.
+ * @return The component numbers of each level.
+ */
+vector<vector<int>> ExceptionFlow::levels(){
+    vector<int> level(components.size(), 0);
+    vector<vector<int>> result;
+
+    for (int i = 0; i < components.size(); i++){
+        for (int scope : components[i]){
+            for (int dep : dependencies(scope)){
+                int other = scopes[dep].component;
+                if (other != i) level[i] = max(level[i], level[other] + 1);
+            }
+        }
+        if (level[i] >= result.size()) result.resize(level[i] + 1);
+        result[level[i]].push_back(i);
+    }
+    return result;
+}
+
+/**
+ * Computes the exceptions arriving in every scope, one component
+ * at a time, iterating each component until it stops changing.
+ * Components of the same level are handed to the thread pool.
+ */
+void ExceptionFlow::summarize(){
+    //A try also writes the caught set of its catches. A catch that reads that
+    //set rethrows and so sits in a later level than its try.
+    for (auto& level : levels()){
+        pool->parallelFor((int) level.size(), [this, &level](int index, int) {
+            summarizeComponent(level[index]);
+        });
+    }
+}
+
+/**
+ * Iterates a single component until it stops changing. Every component
+ * it depends on must already be summarized.
+ * @param component The component number.
+ */
+void ExceptionFlow::summarizeComponent(int component){
+    if (summarized[component]) return;
+    bool changed = true;
+    while (changed){
+        changed = false;
+        for (int scope : components[component]){
+            if (evaluate(scope)) changed = true;
+        }
+        if (!cyclic[component]) break;
+    }
+    summarized[component] = true;
+}
+
+/**
+ * Summarizes a component and everything it depends on that has not
+ * been summarized yet.
+ * @param component The component number.
+ */
+void ExceptionFlow::summarizeSlice(int component){
+    vector<int> slice;
+    vector<int> stack = {component};
+    vector<bool> seen(components.size(), false);
+    seen[component] = true;
+    while (!stack.empty()){
+        int cur = stack.back();
+        stack.pop_back();
+        slice.push_back(cur);
+        for (int scope : components[cur]){
+            for (int dep : dependencies(scope)){
+                int other = scopes[dep].component;
+                if (seen[other] || summarized[other]) continue;
+                seen[other] = true;
+                stack.push_back(other);
+            }
+        }
+    }
+
+    //Components are numbered so dependencies come first.
+    sort(slice.begin(), slice.end());
+    for (int cur : slice) summarizeComponent(cur);
+}
+
+/**
+ * Recomputes a single scope from the scopes feeding it.
+ * @param scope The scope to evaluate.
+ * @return Whether the scope's summary grew.
+ */
+bool ExceptionFlow::evaluate(int scope){
+    Scope& cur = scopes[scope];
+    bool changed = false;
+
+    for (int thrown : cur.localThrows){
+        if (cur.in.test(thrown)) continue;
+        cur.in.set(thrown);
+        changed = true;
+    }
+    for (int feed : cur.feeds){
+        if (cur.in.unite(escapes(feed))) changed = true;
+    }
+    if (cur.rethrows && cur.in.unite(cur.caught)) changed = true;
+
+    //Tries hand exceptions to the first catch whose mask covers them.
+    if (cur.type == ZeldaNode::TRY){
+        ExceptionSet remaining = cur.in;
+        for (int handler : cur.handlers){
+            if (remaining.empty()) break;
+            const ExceptionSet& mask = catchMask(scopes[handler].handlerType);
+            ExceptionSet handled = remaining;
+            handled.intersect(mask);
+            if (scopes[handler].caught.unite(handled)) changed = true;
+            remaining.subtract(mask);
+        }
+        if (cur.esc.unite(remaining)) changed = true;
+    }
+
+    return changed;
+}
+
+/**
+ * Gets the exceptions leaving a scope.
+ * @param scope The scope.
+ * @return The escaping exceptions.
+ */
+const ExceptionSet& ExceptionFlow::escapes(int scope){
+    if (scopes[scope].type == ZeldaNode::TRY) return scopes[scope].esc;
+    return scopes[scope].in;
+}
+
+/**
+ * Finds the catch of a try that handles an exception.
+ * @param tryScope The try scope.
+ * @param thrown The throw index.
+ * @return The catch scope, or -1 if none match.
+ */
+int ExceptionFlow::findHandler(int tryScope, int thrown){
+    for (int handler : scopes[tryScope].handlers){
+        if (scopes[handler].caught.test(thrown)) return handler;
+    }
+    return -1;
+}
+
+/**
+ * Finds the function enclosing a scope.
+ * @param scope The scope.
+ * @return The function scope, or -1.
+ */
+int ExceptionFlow::enclosingFunction(int scope){
+    while (scope != -1 && scopes[scope].type != ZeldaNode::FUNCTION){
+        if (scopes[scope].parent == -1 && scopes[scope].owner != -1) scope = scopes[scope].owner;
+        else scope = scopes[scope].parent;
+    }
+    return scope;
+}
+
+/**
+ * Checks whether a component contains a cycle.
+ * @param component The component number.
+ * @return Whether the component is recursive.
+ */
+bool ExceptionFlow::isCyclic(int component){
+    auto& members = components[component];
+    if (members.size() > 1) return true;
+    for (int dep : dependencies(members[0])){
+        if (dep == members[0]) return true;
+    }
+    return false;
+}
+
+/**
+ * Clears every table built from the graph so it can be read again.
+ */
+void ExceptionFlow::reset(){
+    hierarchy = ClassHierarchy(graph);
+    scopes.clear();
+    scopeIndex.clear();
+    throws.clear();
+    throwIndex.clear();
+    origins.clear();
+    originScope.clear();
+    components.clear();
+    cyclic.clear();
+    summarized.clear();
+    users.clear();
+    destinationMemo.clear();
+    typeIDs.clear();
+    typeNames.clear();
+    typeRanges.clear();
+    typeClasses.clear();
+    matchMemo.clear();
+    catchMasks.clear();
+    maskReady.clear();
+    prepared = false;
+}
+
+/**
+ * Remembers the IDs of the scopes and throws written back, so a later
+ * update can find them even if their nodes were replaced.
+ */
+void ExceptionFlow::recordIDs(){
+    scopeIDs.resize(scopes.size());
+    for (int i = 0; i < scopes.size(); i++) scopeIDs[i] = scopes[i].node->getID();
+    throwIDs.resize(throws.size());
+    for (int i = 0; i < throws.size(); i++) throwIDs[i] = throws[i]->getID();
+}
+
+/**
+ * Removes the edges an earlier write-back derived for a scope. Edges
+ * are found by ID since their nodes may already be gone.
+ * @param old The scopes of the earlier flow.
+ * @param scope The scope in the earlier flow.
+ * @param oldOrigins The origin scope of every earlier throw.
+ * @param throwByID The current number of every throw ID.
+ */
+void ExceptionFlow::removeDerived(const vector<Scope>& old, int scope, const vector<int>& oldOrigins,
+                                  const unordered_map<string, int>& throwByID){
+    const Scope& cur = old[scope];
+    const string& scopeID = scopeIDs[scope];
+    for (int thrown = cur.in.next(0); thrown != -1; thrown = cur.in.next(thrown + 1)){
+        const string& throwID = throwIDs[thrown];
+
+        //A throw that moved into this scope now owns the extracted edge.
+        auto it = throwByID.find(throwID);
+        bool isOrigin = oldOrigins[thrown] == scope;
+        if (it != throwByID.end() && originScope[it->second] != -1){
+            isOrigin = isOrigin || scopes[originScope[it->second]].node->getID() == scopeID;
+        }
+        if (!isOrigin){
+            graph->removeEdge(scopeID, throwID, ZeldaEdge::THROWS, true);
+            graph->removeEdge(scopeID, throwID, ZeldaEdge::THROWPATH, true);
+        }
+        if (cur.type == ZeldaNode::FUNCTION){
+            graph->removeEdge(scopeID, throwID, ZeldaEdge::FUNC_THROWS, true);
+        }
+        for (int handler : cur.handlers){
+            if (!old[handler].caught.test(thrown)) continue;
+            graph->removeEdge(scopeIDs[handler], throwID, ZeldaEdge::CATCHES, true);
+            break;
+        }
+    }
+}
+
+/**
+ * Clears the attributes propagation gives a throw.
+ * @param throwNode The throw node.
+ */
+void ExceptionFlow::resetThrow(ZeldaNode* throwNode){
+    throwNode->removeAttribute("path");
+    throwNode->removeAttribute("functions");
+    throwNode->removeAttribute("funcCount");
+    throwNode->removeAttribute("caughtBy");
+    throwNode->removeAttribute("seenBy");
+    throwNode->removeAttribute("function");
+    throwNode->addBoolAttribute("intermodual", false);
+    throwNode->addBoolAttribute("intermodualCatch", false);
+}
+
+/**
+ * Finds every scope that depends on a starting set of scopes, through
+ * callers, enclosing scopes and the catches of a try.
+ * @param scopes The scopes.
+ * @param users The scopes each scope feeds.
+ * @param start The starting scopes.
+ * @return Whether each scope was reached.
+ */
+vector<char> ExceptionFlow::closure(const vector<Scope>& scopes, const vector<vector<int>>& users, vector<int> start){
+    vector<char> reached(scopes.size(), false);
+    for (int scope : start) reached[scope] = true;
+    while (!start.empty()){
+        int cur = start.back();
+        start.pop_back();
+
+        vector<int> next = users[cur];
+        next.insert(next.end(), scopes[cur].handlers.begin(), scopes[cur].handlers.end());
+        for (int user : next){
+            if (reached[user]) continue;
+            reached[user] = true;
+            start.push_back(user);
+        }
+    }
+    return reached;
+}
+
+/**
+ * Renumbers the throws in a set.
+ * @param set The set in the old numbering.
+ * @param bits The new number of every old throw, or -1 if it is gone.
+ * @return The set in the new numbering.
+ */
+ExceptionSet ExceptionFlow::remap(const ExceptionSet& set, const vector<int>& bits){
+    ExceptionSet result;
+    for (int bit = set.next(0); bit != -1; bit = set.next(bit + 1)){
+        if (bits[bit] != -1) result.set(bits[bit]);
+    }
+    return result;
+}
+
+/**
+ * Writes the computed flow back to the graph as edges and attributes.
+ */
+void ExceptionFlow::materialize(){
+    for (int i = 0; i < throws.size(); i++){
+        throws[i]->addBoolAttribute("intermodual", false, true, false);
+        throws[i]->addBoolAttribute("intermodualCatch", false, true, false);
+    }
+    writeBack(vector<char>(scopes.size(), true), ExceptionSet());
+}
+
+/**
+ * Writes the edges and attributes of the affected scopes, and the
+ * attributes other scopes give to the affected throws. Scopes are
+ * split into ranges that workers turn into deltas; the deltas are
+ * then committed shard by shard.
+ * @param affected Whether each scope is written in full.
+ * @param affectedThrows The throws whose attributes are rebuilt.
+ */
+void ExceptionFlow::writeBack(const vector<char>& affected, const ExceptionSet& affectedThrows){
+    throwFiles.resize(throws.size());
+    throwFunctions.resize(throws.size());
+    for (int i = 0; i < throws.size(); i++){
+        throwFiles[i] = throws[i]->getSingleAttribute(FILENAME_FLAG);
+        throwFunctions[i] = enclosingFunction(originScope[i]);
+    }
+
+    int count = (int) scopes.size();
+    int ranges = min(count, pool->getNumWorkers() * 16);
+    int shards = pool->getNumWorkers() * 4;
+    vector<Delta> deltas(ranges);
+    pool->parallelFor(ranges, [this, count, ranges, shards, &deltas, &affected, &affectedThrows](int range, int) {
+        Delta& delta = deltas[range];
+        delta.bySource.resize(shards);
+        delta.byThrow.resize(shards);
+        delta.byFile.resize(shards);
+        delta.attributes.resize(shards);
+        int last = (int) ((long long) count * (range + 1) / ranges);
+        for (int i = (int) ((long long) count * range / ranges); i < last; i++){
+            if (affected[i]){
+                materializeScope(i, delta, nullptr);
+            } else if (scopes[i].in.intersects(affectedThrows)){
+                materializeScope(i, delta, &affectedThrows);
+            }
+        }
+    });
+
+    commit(deltas, affected, shards);
+}
+
+/**
+ * Records the edges and attributes produced by a single scope. Nothing
+ * in the graph is modified here.
+ * @param i The scope.
+ * @param delta The buffer to record changes in.
+ * @param only If set, only the attributes of these throws are recorded.
+ */
+void ExceptionFlow::materializeScope(int i, Delta& delta, const ExceptionSet* only){
+    Scope& scope = scopes[i];
+    ExceptionSet bits = scope.in;
+    if (only) bits.intersect(*only);
+    bool edges = only == nullptr;
+    ZeldaNode* node = scope.node;
+    ZeldaNode::NodeType type = node->getType();
+    string fileName = node->getSingleAttribute(FILENAME_FLAG);
+    int shards = (int) delta.attributes.size();
+
+    if (edges && type == ZeldaNode::FUNCTION && !scope.in.empty() && cyclic[scope.component]){
+        delta.recursive.push_back(node);
+    }
+
+    for (int thrown = bits.next(0); thrown != -1; thrown = bits.next(thrown + 1)){
+        ZeldaNode* throwNode = throws[thrown];
+        vector<AttributeWrite>& writes = delta.attributes[thrown % shards];
+        bool movesOn = false;
+        int handler = -1;
+
+        if (type == ZeldaNode::TRY){
+            handler = findHandler(i, thrown);
+            for (int seen : scope.handlers){
+                if (seen == handler) break;
+                writes.push_back({throwNode, scopes[seen].node, SEEN_BY});
+            }
+            movesOn = handler != -1 || scope.parent != -1;
+        } else if (type == ZeldaNode::CATCH){
+            movesOn = scope.parent != -1;
+        }
+
+        //Every scope the exception reaches gets an edge to it.
+        ZeldaEdge::EdgeType edgeType = (movesOn) ? ZeldaEdge::THROWPATH : ZeldaEdge::THROWS;
+        if (edges && originScope[thrown] == i){
+            delta.retypes.push_back(make_pair(origins[thrown], edgeType));
+        } else if (edges){
+            addEdge(delta, i, thrown, new ZeldaEdge(node, throwNode, edgeType));
+        }
+        if (movesOn) writes.push_back({throwNode, node, PATH});
+
+        if (type == ZeldaNode::FUNCTION){
+            if (edges) addEdge(delta, i, thrown, new ZeldaEdge(node, throwNode, ZeldaEdge::FUNC_THROWS));
+            writes.push_back({throwNode, node, FUNCTIONS});
+            writes.push_back({throwNode, node, PATH});
+            writes.push_back({throwNode, nullptr, FUNC_COUNT});
+            if (throwFunctions[thrown] == i) writes.push_back({throwNode, node, FUNCTION});
+        }
+
+        //Only calls carry an exception into a scope from another file.
+        if (!fileName.empty() && fileName != throwFiles[thrown]){
+            writes.push_back({throwNode, nullptr, INTERMODUAL});
+        }
+
+        if (handler != -1){
+            ZeldaNode* catchNode = scopes[handler].node;
+            if (edges) addEdge(delta, handler, thrown, new ZeldaEdge(catchNode, throwNode, ZeldaEdge::CATCHES));
+            writes.push_back({throwNode, catchNode, CAUGHT_BY});
+
+            string catchFile = catchNode->getSingleAttribute(FILENAME_FLAG);
+            if (!catchFile.empty() && catchFile != throwFiles[thrown]){
+                writes.push_back({throwNode, nullptr, INTERMODUAL_CATCH});
+                writes.push_back({throwNode, nullptr, INTERMODUAL});
+            }
+            if (!scopes[handler].rethrows) writes.push_back({throwNode, catchNode, PATH});
+        }
+    }
+}
+
+/**
+ * Stamps a new edge and files it under the shards of its source
+ * scope, its throw and its file.
+ * @param delta The buffer to record the edge in.
+ * @param source The scope the edge starts at.
+ * @param thrown The throw the edge ends at.
+ * @param edge The edge.
+ */
+void ExceptionFlow::addEdge(Delta& delta, int source, int thrown, ZeldaEdge* edge){
+    int shards = (int) delta.bySource.size();
+    graph->stampEdge(edge);
+    delta.bySource[source % shards].push_back(edge);
+    delta.byThrow[thrown % shards].push_back(edge);
+    if (edge->getFileID() != -1 || edge->getUnitID() != -1){
+        delta.byFile[(unsigned int) edge->getFileID() % shards].push_back(edge);
+    }
+}
+
+/**
+ * Applies the deltas to the graph. Each shard is applied by one
+ * worker, taking the deltas in range order, so every edge list and
+ * attribute is written in the same order as a single worker would.
+ * @param deltas The recorded changes, by range.
+ * @param affected Whether each scope was written in full.
+ * @param shards The number of shards in each delta.
+ */
+void ExceptionFlow::commit(vector<Delta>& deltas, const vector<char>& affected, int shards){
+    vector<ZeldaNode*> sources;
+    for (int i = 0; i < scopes.size(); i++){
+        if (!affected[i]) continue;
+        sources.push_back(scopes[i].node);
+        for (int handler : scopes[i].handlers) sources.push_back(scopes[handler].node);
+    }
+    graph->reserveEdges(sources, throws);
+
+    pool->parallelFor((int) deltas.size(), [&deltas](int range, int) {
+        for (auto& retype : deltas[range].retypes) retype.first->setType(retype.second);
+        for (ZeldaNode* node : deltas[range].recursive) node->addBoolAttribute("isRecursive", true);
+    });
+
+    pool->parallelFor(shards * 3, [this, shards, &deltas](int task, int) {
+        int shard = task % shards;
+        for (auto& delta : deltas){
+            if (task < shards){
+                for (ZeldaEdge* edge : delta.bySource[shard]) graph->appendBySource(edge);
+            } else if (task < shards * 2){
+                for (ZeldaEdge* edge : delta.byThrow[shard]) graph->appendByDestination(edge);
+                for (auto& write : delta.attributes[shard]) applyAttribute(write);
+            } else {
+                for (ZeldaEdge* edge : delta.byFile[shard]) graph->indexByFile(edge);
+            }
+        }
+    });
+}
+
+/**
+ * Applies one attribute write to its throw.
+ * @param write The write.
+ */
+void ExceptionFlow::applyAttribute(const AttributeWrite& write){
+    const string& key = ATTRIBUTE_NAMES[write.key];
+    switch (ATTRIBUTE_KINDS[write.key]){
+        case MULTI:
+            write.node->addMultiAttribute(key, write.value->getName());
+            break;
+        case SINGLE:
+            write.node->addSingleAttribute(key, write.value->getName());
+            break;
+        case COUNT:
+            write.node->addCountAttribute(key, 1);
+            break;
+        case FLAG:
+            write.node->addBoolAttribute(key, true);
+            break;
+    }
+}
+
+/**
+ * Propagates the throws of one translation unit that are caught before
+ * they leave their function. These need no call graph and are written
+ * to the graph straight away; the global pass skips them afterwards.
+ * A throw that leaves its function is left to the global pass even if
+ * a caller in the same unit catches it, since the walker does not know
+ * which functions other units call. No per-function summaries are kept.
+ * @param graph The graph holding the translation unit.
+ * @param throws The throws recorded for the translation unit.
+ * @return The number of throws resolved.
+ */
+int ExceptionFlow::resolveLocal(TAGraph* graph, const vector<ZeldaNode*>& throws){
+    int resolved = 0;
+    for (ZeldaNode* throwNode : throws){
+        if (throwNode->getType() != ZeldaNode::THROW || throwNode->isResolved()) continue;
+        ZeldaNode* origin = throwNode->getScope();
+        if (!origin) continue;
+
+        //Walk outwards until a handler is found, giving up at the function boundary.
+        vector<pair<ZeldaNode*, ZeldaNode*>> hops;
+        ZeldaNode* handler = nullptr;
+        bool known = true;
+        for (ZeldaNode* cur = origin; cur && known && !handler; ){
+            if (cur->getType() == ZeldaNode::TRY){
+                for (ZeldaNode* candidate : cur->getHandlers()){
+                    int match = matchesLocal(graph, throwNode, candidate);
+                    if (match == -1) known = false;
+                    if (match != 0){
+                        handler = (known) ? candidate : nullptr;
+                        break;
+                    }
+                }
+                hops.push_back(make_pair(cur, handler));
+                cur = cur->getScope();
+            } else if (cur->getType() == ZeldaNode::CATCH){
+                hops.push_back(make_pair(cur, (ZeldaNode*) nullptr));
+                cur = (cur->getOwner()) ? cur->getOwner()->getScope() : nullptr;
+            } else {
+                break;
+            }
+        }
+        if (!known || !handler) continue;
+        if (!graph->findEdgesByTypeAndSrc(handler, ZeldaEdge::RETHROWS).empty()) continue;
+
+        ZeldaEdge* originEdge = nullptr;
+        for (ZeldaEdge* edge : graph->findEdgesByTypeAndSrc(origin, ZeldaEdge::THROWS)){
+            if (edge->getDestination() != throwNode) continue;
+            originEdge = edge;
+            break;
+        }
+        if (!originEdge) continue;
+
+        //Write the same edges and attributes the global pass would.
+        string throwFile = throwNode->getSingleAttribute(FILENAME_FLAG);
+        throwNode->addBoolAttribute("intermodual", false, true, false);
+        throwNode->addBoolAttribute("intermodualCatch", false, true, false);
+        for (auto& hop : hops){
+            ZeldaNode* node = hop.first;
+            for (ZeldaNode* seen : node->getHandlers()){
+                if (seen == hop.second) break;
+                throwNode->addMultiAttribute("seenBy", seen->getName());
+            }
+
+            //Every hop has an enclosing scope, so the exception always moves on. A header
+            //throw walked by an earlier unit already has its path, which is not repeated.
+            bool walked = graph->doesEdgeExist(node->getID(), throwNode->getID(), ZeldaEdge::THROWPATH);
+            if (node == origin){
+                if (walked) graph->removeEdge(originEdge);
+                else originEdge->setType(ZeldaEdge::THROWPATH);
+            } else if (!walked){
+                graph->addEdge(new ZeldaEdge(node, throwNode, ZeldaEdge::THROWPATH));
+            }
+            throwNode->addMultiAttribute("path", node->getName());
+
+            string fileName = node->getSingleAttribute(FILENAME_FLAG);
+            if (!fileName.empty() && fileName != throwFile){
+                throwNode->addBoolAttribute("intermodual", true);
+            }
+        }
+
+        if (!graph->doesEdgeExist(handler->getID(), throwNode->getID(), ZeldaEdge::CATCHES)){
+            graph->addEdge(new ZeldaEdge(handler, throwNode, ZeldaEdge::CATCHES));
+        }
+        throwNode->addMultiAttribute("caughtBy", handler->getName());
+        string catchFile = handler->getSingleAttribute(FILENAME_FLAG);
+        if (!catchFile.empty() && catchFile != throwFile){
+            throwNode->addBoolAttribute("intermodualCatch", true);
+            throwNode->addBoolAttribute("intermodual", true);
+        }
+        throwNode->addMultiAttribute("path", handler->getName());
+
+        throwNode->setResolved(true);
+        resolved++;
+    }
+    return resolved;
+}
+
+/**
+ * Checks whether a handler catches a throw using only the classes
+ * known so far. Class types are compared through their INHERITS
+ * edges; other types only match exactly.
+ * @param graph The graph holding the classes.
+ * @param thrown The throw node.
+ * @param handler The catch node.
+ * @return 1 if it matches, 0 if it does not and -1 if it cannot be told yet.
+ */
+int ExceptionFlow::matchesLocal(TAGraph* graph, ZeldaNode* thrown, ZeldaNode* handler){
+    string thrownKey = typeKey(thrown);
+    string handlerKey = typeKey(handler);
+    if (handlerKey == CATCH_ALL || handlerKey == thrownKey) return 1;
+
+    string thrownClass = thrown->getSingleAttribute(TYPE_CLASS_FLAG);
+    string handlerClass = handler->getSingleAttribute(TYPE_CLASS_FLAG);
+    if (thrownClass.empty() || handlerClass.empty()) return -1;
+    if (!graph->findNode(thrownClass)) return 0;
+
+    //INHERITS edges run from the base class to the derived class.
+    vector<string> stack = {thrownClass};
+    unordered_map<string, bool> seen;
+    while (!stack.empty()){
+        string cur = stack.back();
+        stack.pop_back();
+        for (ZeldaEdge* edge : graph->findEdgesByDst(cur)){
+            if (edge->getType() != ZeldaEdge::INHERITS) continue;
+            string base = edge->getSourceID();
+            ZeldaNode* baseNode = graph->findNode(base);
+            if (!baseNode || baseNode->getType() != ZeldaNode::CLASS || seen[base]) continue;
+            if (base == handlerClass) return 1;
+            seen[base] = true;
+            stack.push_back(base);
+        }
+    }
+    return 0;
+}
+
+/**
+ * Interns every thrown type and renumbers the throws so that
+ * each type owns a contiguous range of bits.
+ */
+void ExceptionFlow::internTypes(){
+    vector<pair<string, ZeldaNode*>> typed;
+    for (ZeldaNode* node : throws){
+        typed.push_back(make_pair(typeKey(node), node));
+    }
+    sort(typed.begin(), typed.end(), [](const pair<string, ZeldaNode*>& first, const pair<string, ZeldaNode*>& second) -> bool {
+        if (first.first != second.first) return first.first < second.first;
+        return compareNodes(first.second, second.second);
+    });
+
+    throws.clear();
+    for (int i = 0; i < typed.size(); i++){
+        if (i == 0 || typed[i].first != typed[i - 1].first){
+            typeIDs[typed[i].first] = (int) typeNames.size();
+            typeNames.push_back(typed[i].first);
+            typeRanges.push_back(make_pair(i, i));
+            typeClasses.push_back(hierarchy.findClass(typed[i].first));
+            catchMasks.push_back(ExceptionSet());
+            maskReady.push_back(false);
+        }
+        typeRanges.back().second = i + 1;
+        throws.push_back(typed[i].second);
+    }
+    catchAllType = lookupType(CATCH_ALL);
+}
+
+/**
+ * Gets the key a node's exception type is interned under. Types that
+ * resolved to a class during extraction use the class ID so differently
+ * spelled names of one record share an ID.
+ * @param node The throw or catch node.
+ * @return The type key.
+ */
+string ExceptionFlow::typeKey(ZeldaNode* node){
+    string key = node->getSingleAttribute(TYPE_CLASS_FLAG);
+    if (!key.empty()) return key;
+
+    key = node->getSingleAttribute(TYPE_FLAG);
+    cleanType(key);
+    return key;
+}
+
+/**
+ * Gets the dense ID of a type, interning it if needed.
+ * @param key The type key.
+ * @return The type ID.
+ */
+int ExceptionFlow::lookupType(const string& key){
+    auto it = typeIDs.find(key);
+    if (it != typeIDs.end()) return it->second;
+
+    int id = (int) typeNames.size();
+    typeIDs[key] = id;
+    typeNames.push_back(key);
+    typeClasses.push_back(hierarchy.findClass(key));
+    catchMasks.push_back(ExceptionSet());
+    maskReady.push_back(false);
+    return id;
+}
+
+/**
+ * Builds the mask of every handler type in use before the workers
+ * start, so the shared mask and match tables are only read in parallel.
+ */
+void ExceptionFlow::prepareMasks(){
+    for (auto& scope : scopes){
+        if (scope.handlerType != -1) catchMask(scope.handlerType);
+    }
+}
+
+/**
+ * Gets the throws a handler type catches. Masks are built once per
+ * handler type and shared by every catch of that type.
+ * @param handlerType The handler type ID.
+ * @return The mask of caught throws.
+ */
+const ExceptionSet& ExceptionFlow::catchMask(int handlerType){
+    if (!maskReady[handlerType]){
+        ExceptionSet& mask = catchMasks[handlerType];
+        for (int thrownType = 0; thrownType < typeRanges.size(); thrownType++){
+            if (!matchesType(thrownType, handlerType)) continue;
+            mask.setRange(typeRanges[thrownType].first, typeRanges[thrownType].second);
+        }
+        maskReady[handlerType] = true;
+    }
+    return catchMasks[handlerType];
+}
+
+/**
+ * Checks whether a handler type catches a thrown type. Results are
+ * memoized per pair of type IDs.
+ * @param thrownType The thrown type ID.
+ * @param handlerType The handler type ID.
+ * @return Whether the handler catches the type.
+ */
+bool ExceptionFlow::matchesType(int thrownType, int handlerType){
+    if (handlerType == catchAllType || thrownType == handlerType) return true;
+
+    long long key = ((long long) thrownType << 32) | (unsigned int) handlerType;
+    auto it = matchMemo.find(key);
+    if (it != matchMemo.end()) return it->second;
+
+    bool result = hierarchy.isSubclass(typeClasses[thrownType], typeClasses[handlerType]);
+    matchMemo[key] = result;
+    return result;
+}
@@ -0,0 +1,186 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ExceptionFlow.h
+//
+// Summary-based exception propagation for Zelda.
+// Functions, try blocks and catch blocks are treated
+// as scopes. The scope graph is condensed into strongly
+// connected components and each scope's escaping
+// exceptions are computed bottom-up to a fixpoint
+// before any THROWS, CATCHES or FUNC_THROWS edges are
+// written back to the graph. Independent components
+// and the write-back of separate scopes are spread over
+// a thread pool; writes are buffered per worker, sharded
+// by source, throw and file, and each shard is committed
+// by one worker in scope order so output is deterministic.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef ZELDA_EXCEPTIONFLOW_H
+#define ZELDA_EXCEPTIONFLOW_H
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "TAGraph.h"
+#include "ExceptionSet.h"
+#include "ClassHierarchy.h"
+#include "ThreadPool.h"
+
+class ExceptionFlow {
+public:
+    //How far a throw travels. Route lengths follow the shortest route to
+    //a catch or to a function without callers, and are -1 if neither is reached.
+    struct ThrowMetrics {
+        ZeldaNode* throwNode;
+        int frames;                     //Scopes unwound on the route.
+        int functionHops;               //Functions unwound on the route.
+        int functions;                  //Functions the throw can pass through.
+        int handlers;                   //Catches that can handle it.
+        bool escapes;                   //Whether it can leave a function without callers.
+        bool intermodual;
+    };
+
+    //Constructor/Destructor
+    explicit ExceptionFlow(TAGraph* graph, int workers = 0);
+    ~ExceptionFlow();
+
+    //Propagation
+    void run();
+    void update(const std::vector<ZeldaNode*>& changed);
+    static int resolveLocal(TAGraph* graph, const std::vector<ZeldaNode*>& throws);
+
+    //Demand-Driven Queries
+    void prepare();
+    std::vector<ZeldaNode*> queryEscapes(ZeldaNode* function);
+    std::vector<ZeldaNode*> queryDestinations(ZeldaNode* throwNode);
+    std::vector<ZeldaNode*> queryPath(ZeldaNode* throwNode, ZeldaNode* destination);
+
+    //Metrics
+    std::vector<ThrowMetrics> measure();
+
+private:
+    struct Scope {
+        ZeldaNode* node;
+        ZeldaNode::NodeType type;
+        int parent;                     //Enclosing scope of a try or catch.
+        int owner;                      //Try that owns a catch.
+        bool rethrows;
+        std::vector<int> handlers;      //Catches of a try, in source order.
+        std::vector<int> feeds;         //Scopes whose escaping exceptions arrive here.
+        std::vector<int> localThrows;
+        int handlerType;                //Interned type a catch handles.
+        int component;
+        ExceptionSet in;                //Exceptions arriving in this scope.
+        ExceptionSet caught;            //Exceptions a catch handles.
+        ExceptionSet esc;               //Exceptions escaping a try.
+    };
+
+    //Attributes written to throws. Values are the names of scope nodes.
+    enum AttributeKey {SEEN_BY, PATH, FUNCTIONS, FUNC_COUNT, FUNCTION, INTERMODUAL, INTERMODUAL_CATCH, CAUGHT_BY};
+    struct AttributeWrite {
+        ZeldaNode* node;
+        ZeldaNode* value;
+        AttributeKey key;
+    };
+
+    //Graph changes made by one worker. New edges and attribute writes are
+    //bucketed into shards so that each shard can be applied by one worker.
+    struct Delta {
+        std::vector<std::pair<ZeldaEdge*, ZeldaEdge::EdgeType>> retypes;
+        std::vector<ZeldaNode*> recursive;
+        std::vector<std::vector<ZeldaEdge*>> bySource;
+        std::vector<std::vector<ZeldaEdge*>> byThrow;
+        std::vector<std::vector<ZeldaEdge*>> byFile;
+        std::vector<std::vector<AttributeWrite>> attributes;
+    };
+
+    TAGraph* graph;
+    ClassHierarchy hierarchy;
+    std::vector<Scope> scopes;
+    std::unordered_map<ZeldaNode*, int> scopeIndex;
+    std::vector<ZeldaNode*> throws;
+    std::unordered_map<ZeldaNode*, int> throwIndex;
+    std::vector<ZeldaEdge*> origins;
+    std::vector<int> originScope;
+    std::vector<std::vector<int>> components;
+    std::vector<bool> cyclic;
+    std::vector<char> summarized;
+    std::vector<std::vector<int>> users;
+    std::unordered_map<int, std::vector<ZeldaNode*>> destinationMemo;
+    bool prepared;
+    bool materialized;
+    std::vector<std::string> scopeIDs;  //IDs as of the last write-back.
+    std::vector<std::string> throwIDs;
+    std::vector<std::string> throwFiles;
+    std::vector<int> throwFunctions;
+    int workers;
+    ThreadPool* pool;
+
+    //Type Tables
+    std::unordered_map<std::string, int> typeIDs;
+    std::vector<std::string> typeNames;
+    std::vector<std::pair<int, int>> typeRanges;
+    std::vector<int> typeClasses;
+    std::unordered_map<long long, bool> matchMemo;
+    std::vector<ExceptionSet> catchMasks;
+    std::vector<bool> maskReady;
+    int catchAllType;
+
+    //Phases
+    void buildScopes();
+    void condense();
+    void summarize();
+    void materialize();
+    void writeBack(const std::vector<char>& affected, const ExceptionSet& affectedThrows);
+    void materializeScope(int scope, Delta& delta, const ExceptionSet* only);
+    void addEdge(Delta& delta, int source, int thrown, ZeldaEdge* edge);
+    void commit(std::vector<Delta>& deltas, const std::vector<char>& affected, int shards);
+    static void applyAttribute(const AttributeWrite& write);
+
+    //Incremental Helpers
+    void reset();
+    void recordIDs();
+    void removeDerived(const std::vector<Scope>& old, int scope, const std::vector<int>& oldOrigins,
+                       const std::unordered_map<std::string, int>& throwByID);
+    void resetThrow(ZeldaNode* throwNode);
+    static std::vector<char> closure(const std::vector<Scope>& scopes, const std::vector<std::vector<int>>& users,
+                                     std::vector<int> start);
+    static ExceptionSet remap(const ExceptionSet& set, const std::vector<int>& bits);
+
+    //Summary Helpers
+    void summarizeComponent(int component);
+    void summarizeSlice(int component);
+    bool evaluate(int scope);
+    const ExceptionSet& escapes(int scope);
+    std::vector<int> dependencies(int scope);
+    int findHandler(int tryScope, int thrown);
+    int enclosingFunction(int scope);
+    bool isCyclic(int component);
+    void measureThrow(int thrown, ThrowMetrics& metrics, std::vector<int>& seen,
+                      std::vector<std::pair<int, int>>& depth);
+    int localFrames(ZeldaNode* throwNode);
+    std::vector<std::vector<int>> levels();
+
+    //Type Helpers
+    void internTypes();
+    static std::string typeKey(ZeldaNode* node);
+    static int matchesLocal(TAGraph* graph, ZeldaNode* thrown, ZeldaNode* handler);
+    int lookupType(const std::string& key);
+    void prepareMasks();
+    const ExceptionSet& catchMask(int handlerType);
+    bool matchesType(int thrownType, int handlerType);
+};
+
+#endif //ZELDA_EXCEPTIONFLOW_H
@@ -0,0 +1,214 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ExceptionSet.cpp
+//
+// Dense bitset used as the lattice element of exception
+// propagation. Bits are throw sites numbered so that all
+// throws of one exception type are contiguous; a set of
+// exception types is therefore a union of bit ranges and
+// merging or filtering sets is done a word at a time.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include "ExceptionSet.h"
+
+using namespace std;
+
+static const int WORD_BITS = 64;
+
+/**
+ * Creates an empty set.
+ */
+ExceptionSet::ExceptionSet(){ }
+
+/**
+ * Destructor.
+ */
+ExceptionSet::~ExceptionSet(){ }
+
+/**
+ * Adds a bit to the set.
+ * @param bit The bit to add.
+ */
+void ExceptionSet::set(int bit){
+    grow(bit / WORD_BITS + 1);
+    words[bit / WORD_BITS] |= (uint64_t) 1 << (bit % WORD_BITS);
+}
+
+/**
+ * Adds every bit in [first, last) to the set.
+ * @param first The first bit.
+ * @param last One past the last bit.
+ */
+void ExceptionSet::setRange(int first, int last){
+    if (first >= last) return;
+    grow((last - 1) / WORD_BITS + 1);
+
+    while (first < last){
+        int word = first / WORD_BITS;
+        int offset = first % WORD_BITS;
+        int span = min(WORD_BITS - offset, last - first);
+        uint64_t mask = (span == WORD_BITS) ? ~(uint64_t) 0 : (((uint64_t) 1 << span) - 1) << offset;
+        words[word] |= mask;
+        first += span;
+    }
+}
+
+/**
+ * Removes a bit from the set.
+ * @param bit The bit to remove.
+ */
+void ExceptionSet::reset(int bit){
+    if (bit / WORD_BITS >= words.size()) return;
+    words[bit / WORD_BITS] &= ~((uint64_t) 1 << (bit % WORD_BITS));
+    trim();
+}
+
+/**
+ * Checks whether a bit is in the set.
+ * @param bit The bit to check.
+ * @return Whether the bit is set.
+ */
+bool ExceptionSet::test(int bit) const {
+    if (bit / WORD_BITS >= words.size()) return false;
+    return (words[bit / WORD_BITS] >> (bit % WORD_BITS)) & 1;
+}
+
+/**
+ * Empties the set and releases its storage.
+ */
+void ExceptionSet::clear(){
+    vector<uint64_t>().swap(words);
+}
+
+/**
+ * Checks whether the set is empty.
+ * @return Whether no bits are set.
+ */
+bool ExceptionSet::empty() const {
+    return words.empty();
+}
+
+/**
+ * Counts the bits in the set.
+ * @return The number of set bits.
+ */
+int ExceptionSet::count() const {
+    int total = 0;
+    for (uint64_t word : words) total += __builtin_popcountll(word);
+    return total;
+}
+
+/**
+ * Finds the next set bit.
+ * @param bit The bit to start searching from.
+ * @return The first set bit at or after the given bit, or -1.
+ */
+int ExceptionSet::next(int bit) const {
+    if (bit < 0) bit = 0;
+    size_t word = bit / WORD_BITS;
+    if (word >= words.size()) return -1;
+
+    uint64_t cur = words[word] & (~(uint64_t) 0 << (bit % WORD_BITS));
+    while (true){
+        if (cur) return (int) (word * WORD_BITS + __builtin_ctzll(cur));
+        if (++word >= words.size()) return -1;
+        cur = words[word];
+    }
+}
+
+/**
+ * Checks whether two sets share a bit.
+ * @param other The other set.
+ * @return Whether the sets intersect.
+ */
+bool ExceptionSet::intersects(const ExceptionSet& other) const {
+    size_t size = min(words.size(), other.words.size());
+    for (size_t i = 0; i < size; i++){
+        if (words[i] & other.words[i]) return true;
+    }
+    return false;
+}
+
+/**
+ * Compares two sets.
+ * @param other The other set.
+ * @return Whether both sets hold the same bits.
+ */
+bool ExceptionSet::operator==(const ExceptionSet& other) const {
+    return words == other.words;
+}
+
+/**
+ * Adds every bit of another set.
+ * @param other The set to merge in.
+ * @return Whether this set changed.
+ */
+bool ExceptionSet::unite(const ExceptionSet& other){
+    grow(other.words.size());
+
+    bool changed = false;
+    for (size_t i = 0; i < other.words.size(); i++){
+        uint64_t merged = words[i] | other.words[i];
+        if (merged != words[i]){
+            words[i] = merged;
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+/**
+ * Removes every bit of another set.
+ * @param other The set to remove.
+ */
+void ExceptionSet::subtract(const ExceptionSet& other){
+    size_t size = min(words.size(), other.words.size());
+    for (size_t i = 0; i < size; i++) words[i] &= ~other.words[i];
+    trim();
+}
+
+/**
+ * Keeps only the bits shared with another set.
+ * @param other The set to intersect with.
+ */
+void ExceptionSet::intersect(const ExceptionSet& other){
+    if (words.size() > other.words.size()) words.resize(other.words.size());
+    for (size_t i = 0; i < words.size(); i++) words[i] &= other.words[i];
+    trim();
+}
+
+/**
+ * Gets the heap storage used by the set.
+ * @return The number of bytes allocated.
+ */
+size_t ExceptionSet::bytes() const {
+    return words.capacity() * sizeof(uint64_t);
+}
+
+/**
+ * Makes room for a number of words.
+ * @param size The number of words needed.
+ */
+void ExceptionSet::grow(size_t size){
+    if (words.size() < size) words.resize(size, 0);
+}
+
+/**
+ * Drops empty high words so equal sets compare equal.
+ */
+void ExceptionSet::trim(){
+    while (!words.empty() && words.back() == 0) words.pop_back();
+}
@@ -0,0 +1,65 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ExceptionSet.h
+//
+// Dense bitset used as the lattice element of exception
+// propagation. Bits are throw sites numbered so that all
+// throws of one exception type are contiguous; a set of
+// exception types is therefore a union of bit ranges and
+// merging or filtering sets is done a word at a time.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef ZELDA_EXCEPTIONSET_H
+#define ZELDA_EXCEPTIONSET_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class ExceptionSet {
+public:
+    //Constructor/Destructor
+    ExceptionSet();
+    ~ExceptionSet();
+
+    //Bit Operations
+    void set(int bit);
+    void setRange(int first, int last);
+    void reset(int bit);
+    bool test(int bit) const;
+    void clear();
+
+    //Queries
+    bool empty() const;
+    int count() const;
+    int next(int bit) const;
+    bool intersects(const ExceptionSet& other) const;
+    bool operator==(const ExceptionSet& other) const;
+
+    //Set Operations
+    bool unite(const ExceptionSet& other);
+    void subtract(const ExceptionSet& other);
+    void intersect(const ExceptionSet& other);
+    size_t bytes() const;
+
+private:
+    //Sets only allocate up to their highest word, so sparse scopes stay small.
+    std::vector<uint64_t> words;
+
+    void grow(size_t size);
+    void trim();
+};
+
+#endif //ZELDA_EXCEPTIONSET_H
@@ -0,0 +1,80 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// FileTable.cpp
+//
+// Interns source file paths so that nodes and edges can
+// record where they came from with a single integer. IDs
+// are handed out in order of first use and stay valid for
+// the lifetime of the process.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "FileTable.h"
+
+using namespace std;
+
+const int FileTable::NO_FILE;
+mutex FileTable::lock;
+LockWaits::Site FileTable::waits("FileTable");
+unordered_map<string, int> FileTable::ids;
+vector<string> FileTable::names;
+
+/**
+ * Gets the ID of a file, adding it to the table if it is new.
+ * @param fileName The normalized file path.
+ * @return The ID of the file, or NO_FILE for an empty path.
+ */
+int FileTable::intern(const string& fileName){
+    if (fileName.empty()) return NO_FILE;
+
+    LockWaits::Guard guard(lock, waits);
+    auto it = ids.find(fileName);
+    if (it != ids.end()) return it->second;
+
+    int fileID = (int) names.size();
+    names.push_back(fileName);
+    ids[fileName] = fileID;
+    return fileID;
+}
+
+/**
+ * Looks up a file without adding it.
+ * @param fileName The normalized file path.
+ * @return The ID of the file, or NO_FILE if it was never seen.
+ */
+int FileTable::find(const string& fileName){
+    LockWaits::Guard guard(lock, waits);
+    auto it = ids.find(fileName);
+    return (it == ids.end()) ? NO_FILE : it->second;
+}
+
+/**
+ * Gets the path of an interned file.
+ * @param fileID The ID of the file.
+ * @return The path, or an empty string for an unknown ID.
+ */
+string FileTable::getName(int fileID){
+    LockWaits::Guard guard(lock, waits);
+    if (fileID < 0 || fileID >= (int) names.size()) return string();
+    return names[fileID];
+}
+
+/**
+ * Gets the number of interned files.
+ * @return The number of files.
+ */
+int FileTable::size(){
+    LockWaits::Guard guard(lock, waits);
+    return (int) names.size();
+}
@@ -0,0 +1,51 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// FileTable.h
+//
+// Interns source file paths so that nodes and edges can
+// record where they came from with a single integer. IDs
+// are handed out in order of first use and stay valid for
+// the lifetime of the process.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef ZELDA_FILETABLE_H
+#define ZELDA_FILETABLE_H
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "LockWaits.h"
+
+class FileTable {
+public:
+    static const int NO_FILE = -1;
+
+    //Interning
+    static int intern(const std::string& fileName);
+    static int find(const std::string& fileName);
+
+    //Getters
+    static std::string getName(int fileID);
+    static int size();
+
+private:
+    static std::mutex lock;
+    static LockWaits::Site waits;
+    static std::unordered_map<std::string, int> ids;
+    static std::vector<std::string> names;
+};
+
+#endif //ZELDA_FILETABLE_H
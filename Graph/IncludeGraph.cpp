@@ -0,0 +1,142 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// IncludeGraph.cpp
+//
+// Records which files each translation unit included, so
+// that a later run can work out which units a change to
+// some files can affect. The graph is saved alongside the
+// other outputs of a run.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <fstream>
+#include "IncludeGraph.h"
+#include "../JSON/json.h"
+
+using namespace std;
+
+mutex IncludeGraph::lock;
+LockWaits::Site IncludeGraph::waits("IncludeGraph");
+map<string, set<pair<string, string>>> IncludeGraph::units;
+
+/**
+ * Starts recording a unit, dropping what an earlier walk of it recorded.
+ * @param unit The normalized name of the unit.
+ */
+void IncludeGraph::beginUnit(const string& unit){
+    LockWaits::Guard guard(lock, waits);
+    units[unit].clear();
+}
+
+/**
+ * Records an include directive seen while preprocessing a unit.
+ * @param unit The normalized name of the unit.
+ * @param includer The file containing the directive.
+ * @param included The file it includes.
+ */
+void IncludeGraph::addInclude(const string& unit, const string& includer, const string& included){
+    LockWaits::Guard guard(lock, waits);
+    units[unit].insert(make_pair(includer, included));
+}
+
+/**
+ * Finds the units that include any of the changed files, directly or
+ * through other headers, along with changed units themselves.
+ * @param changed The normalized names of the changed files.
+ * @return The normalized names of the impacted units.
+ */
+set<string> IncludeGraph::impactedUnits(const set<string>& changed){
+    LockWaits::Guard guard(lock, waits);
+    set<string> impacted;
+    for (auto& unit : units){
+        if (changed.count(unit.first)){
+            impacted.insert(unit.first);
+            continue;
+        }
+
+        //Every edge of a unit was reached from it, so one changed target is enough.
+        for (auto& edge : unit.second){
+            if (changed.count(edge.second)){
+                impacted.insert(unit.first);
+                break;
+            }
+        }
+    }
+    return impacted;
+}
+
+/**
+ * Gets the number of recorded units.
+ * @return The number of units.
+ */
+int IncludeGraph::getNumUnits(){
+    LockWaits::Guard guard(lock, waits);
+    return (int) units.size();
+}
+
+/**
+ * Saves the include graph as JSON.
+ * @param fileName The file to write.
+ * @return Boolean indicating success.
+ */
+bool IncludeGraph::save(const string& fileName){
+    Json::Value root(Json::objectValue);
+    {
+        LockWaits::Guard guard(lock, waits);
+        for (auto& unit : units){
+            Json::Value edges(Json::arrayValue);
+            for (auto& edge : unit.second){
+                Json::Value entry(Json::arrayValue);
+                entry.append(edge.first);
+                entry.append(edge.second);
+                edges.append(entry);
+            }
+            root[unit.first] = edges;
+        }
+    }
+
+    std::ofstream out(fileName);
+    if (!out.is_open()) return false;
+    out << root;
+    return out.good();
+}
+
+/**
+ * Loads a saved include graph, replacing the units it names.
+ * @param fileName The file to read.
+ * @return Boolean indicating success.
+ */
+bool IncludeGraph::load(const string& fileName){
+    std::ifstream in(fileName, std::ifstream::binary);
+    if (!in.is_open()) return false;
+
+    Json::Value root;
+    try {
+        in >> root;
+    } catch (Json::Exception& e){
+        return false;
+    }
+    if (!root.isObject()) return false;
+
+    LockWaits::Guard guard(lock, waits);
+    for (auto& name : root.getMemberNames()){
+        set<pair<string, string>>& edges = units[name];
+        edges.clear();
+        for (auto& edge : root[name]){
+            if (!edge.isArray() || edge.size() != 2) continue;
+            edges.insert(make_pair(edge[0].asString(), edge[1].asString()));
+        }
+    }
+    return true;
+}
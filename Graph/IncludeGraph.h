@@ -0,0 +1,55 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// IncludeGraph.h
+//
+// Records which files each translation unit included, so
+// that a later run can work out which units a change to
+// some files can affect. The graph is saved alongside the
+// other outputs of a run.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef ZELDA_INCLUDEGRAPH_H
+#define ZELDA_INCLUDEGRAPH_H
+
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <utility>
+#include "LockWaits.h"
+
+class IncludeGraph {
+public:
+    //Recording
+    static void beginUnit(const std::string& unit);
+    static void addInclude(const std::string& unit, const std::string& includer, const std::string& included);
+
+    //Queries
+    static std::set<std::string> impactedUnits(const std::set<std::string>& changed);
+    static int getNumUnits();
+
+    //Persistence
+    static bool save(const std::string& fileName);
+    static bool load(const std::string& fileName);
+
+private:
+    static std::mutex lock;
+    static LockWaits::Site waits;
+
+    //The include edges seen while each unit was preprocessed.
+    static std::map<std::string, std::set<std::pair<std::string, std::string>>> units;
+};
+
+#endif //ZELDA_INCLUDEGRAPH_H
@@ -0,0 +1,101 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// LockWaits.cpp
+//
+// Measures waits on the locks of shared tables.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <chrono>
+#include "LockWaits.h"
+
+using namespace std;
+
+/**
+ * Registers a table. Sites are static members, so this runs during static initialization.
+ * @param name The table name, such as FileTable.
+ */
+LockWaits::Site::Site(const string& name) : name(name), acquisitions(0), contended(0), waitNanos(0) {
+    lock_guard<mutex> guard(registryLock());
+    sites().push_back(this);
+}
+
+/**
+ * Takes a mutex. The clock is only read if the mutex is already held.
+ * @param mutex The mutex.
+ * @param site The table it guards.
+ */
+LockWaits::Guard::Guard(std::mutex& mutex, Site& site) : mutex(mutex) {
+    site.acquisitions.fetch_add(1, memory_order_relaxed);
+    if (mutex.try_lock()) return;
+
+    auto start = chrono::steady_clock::now();
+    mutex.lock();
+    long long waited = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+    site.contended.fetch_add(1, memory_order_relaxed);
+    site.waitNanos.fetch_add(waited, memory_order_relaxed);
+}
+
+/**
+ * Releases the mutex.
+ */
+LockWaits::Guard::~Guard(){
+    mutex.unlock();
+}
+
+/**
+ * Gets the waits on every table that was locked, longest first.
+ * @return A list of {name, acquisitions, contended, waitSeconds}.
+ */
+Json::Value LockWaits::toJson(){
+    lock_guard<mutex> guard(registryLock());
+    vector<Site*> order;
+    for (Site* site : sites()){
+        if (site->acquisitions.load() > 0) order.push_back(site);
+    }
+    stable_sort(order.begin(), order.end(), [](Site* first, Site* second) -> bool {
+        return first->waitNanos.load() > second->waitNanos.load();
+    });
+
+    Json::Value list(Json::arrayValue);
+    for (Site* site : order){
+        Json::Value entry(Json::objectValue);
+        entry["name"] = site->name;
+        entry["acquisitions"] = Json::UInt64(site->acquisitions.load());
+        entry["contended"] = Json::UInt64(site->contended.load());
+        entry["waitSeconds"] = site->waitNanos.load() / 1e9;
+        list.append(entry);
+    }
+    return list;
+}
+
+/**
+ * Gets the lock of the site list. It is made on first use so sites
+ * in any translation unit can register during static initialization.
+ * @return The lock.
+ */
+mutex& LockWaits::registryLock(){
+    static mutex registry;
+    return registry;
+}
+
+/**
+ * Gets the registered sites.
+ * @return The sites.
+ */
+vector<LockWaits::Site*>& LockWaits::sites(){
+    static vector<Site*> registered;
+    return registered;
+}
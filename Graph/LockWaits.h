@@ -0,0 +1,67 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// LockWaits.h
+//
+// Measures how often threads find the lock of a shared
+// table already held, and how long they wait for it.
+// Uncontended locks cost one try_lock, so the guard can
+// stay in release builds.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef ZELDA_LOCKWAITS_H
+#define ZELDA_LOCKWAITS_H
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "../JSON/json.h"
+
+class LockWaits {
+public:
+    //One shared table whose lock is measured. Sites register themselves when constructed.
+    class Site {
+    public:
+        explicit Site(const std::string& name);
+
+    private:
+        friend class LockWaits;
+        std::string name;
+        std::atomic<unsigned long long> acquisitions;
+        std::atomic<unsigned long long> contended;
+        std::atomic<long long> waitNanos;
+    };
+
+    //Holds a mutex until destroyed, timing the wait if another thread had it.
+    class Guard {
+    public:
+        Guard(std::mutex& mutex, Site& site);
+        ~Guard();
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+
+    private:
+        std::mutex& mutex;
+    };
+
+    //Reporting
+    static Json::Value toJson();
+
+private:
+    static std::mutex& registryLock();
+    static std::vector<Site*>& sites();
+};
+
+#endif //ZELDA_LOCKWAITS_H
@@ -0,0 +1,177 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// MemoryReport.cpp
+//
+// Breaks down how much memory a graph holds.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <sstream>
+#include <utility>
+#include <vector>
+#include "MemoryReport.h"
+
+using namespace std;
+
+const size_t MemoryReport::TREE_NODE;
+const size_t MemoryReport::HASH_NODE;
+
+/**
+ * Adds a node object and the fields it owns directly.
+ * @param type The node type.
+ * @param bytes The bytes it holds.
+ */
+void MemoryReport::addNode(const string& type, size_t bytes){
+    nodes[type].count++;
+    nodes[type].bytes += bytes;
+}
+
+/**
+ * Adds an edge object and the fields it owns directly.
+ * @param type The edge type.
+ * @param bytes The bytes it holds.
+ */
+void MemoryReport::addEdge(const string& type, size_t bytes){
+    edges[type].count++;
+    edges[type].bytes += bytes;
+}
+
+/**
+ * Adds one attribute of a node or edge, including its key and values.
+ * @param key The attribute key.
+ * @param bytes The bytes it holds.
+ */
+void MemoryReport::addAttribute(const string& key, size_t bytes){
+    attributes[key].count++;
+    attributes[key].bytes += bytes;
+}
+
+/**
+ * Adds the heap buffers of IDs, names and index keys.
+ * @param bytes The bytes they hold.
+ */
+void MemoryReport::addStrings(size_t bytes){
+    strings += bytes;
+}
+
+/**
+ * Adds the structure of one of the graph's indexes.
+ * @param name The index name.
+ * @param bytes The bytes it holds.
+ * @param entries The number of entries it has.
+ */
+void MemoryReport::addTable(const string& name, size_t bytes, size_t entries){
+    tables[name].count += entries;
+    tables[name].bytes += bytes;
+}
+
+/**
+ * Gets the bytes of every category together.
+ * @return The total, in bytes.
+ */
+size_t MemoryReport::total() const {
+    size_t sum = strings;
+    for (auto* usage : {&nodes, &edges, &attributes, &tables}){
+        for (auto& entry : *usage) sum += entry.second.bytes;
+    }
+    return sum;
+}
+
+/**
+ * Converts the report to JSON.
+ * @return The report, with every size in bytes.
+ */
+Json::Value MemoryReport::toJson() const {
+    Json::Value root(Json::objectValue);
+    root["totalBytes"] = Json::UInt64(total());
+    root["nodes"] = usageToJson(nodes);
+    root["edges"] = usageToJson(edges);
+    root["attributes"] = usageToJson(attributes);
+    root["stringBytes"] = Json::UInt64(strings);
+    root["tables"] = usageToJson(tables);
+    return root;
+}
+
+/**
+ * Converts the report to text, one line per entry and the
+ * largest entries of each category first.
+ * @return The report.
+ */
+string MemoryReport::toString() const {
+    ostringstream out;
+    out << "total " << total() << "\n";
+    usageToString("node", nodes, out);
+    usageToString("edge", edges, out);
+    usageToString("attribute", attributes, out);
+    out << "strings " << strings << "\n";
+    usageToString("table", tables, out);
+    return out.str();
+}
+
+/**
+ * Estimates the heap buffer of a string. Short strings are kept
+ * inside the string itself and take none.
+ * @param str The string.
+ * @return The bytes it holds outside itself.
+ */
+size_t MemoryReport::heapBytes(const string& str){
+    const char* data = str.data();
+    const char* self = reinterpret_cast<const char*>(&str);
+    if (data >= self && data < self + sizeof(string)) return 0;
+    return str.capacity() + 1;
+}
+
+/**
+ * Estimates the entries of a set of values and their heap buffers.
+ * @param values The values.
+ * @return The bytes they hold outside the set itself.
+ */
+size_t MemoryReport::heapBytes(const set<string>& values){
+    size_t bytes = treeBytes(values);
+    for (auto& value : values) bytes += heapBytes(value);
+    return bytes;
+}
+
+/**
+ * Converts one category to JSON.
+ * @param usage The category.
+ * @return An object of {count, bytes} by name.
+ */
+Json::Value MemoryReport::usageToJson(const map<string, Usage>& usage){
+    Json::Value root(Json::objectValue);
+    for (auto& entry : usage){
+        Json::Value cur(Json::objectValue);
+        cur["count"] = Json::UInt64(entry.second.count);
+        cur["bytes"] = Json::UInt64(entry.second.bytes);
+        root[entry.first] = cur;
+    }
+    return root;
+}
+
+/**
+ * Writes one category as text, largest first.
+ * @param category The category label.
+ * @param usage The category.
+ * @param out Receives one line per entry.
+ */
+void MemoryReport::usageToString(const string& category, const map<string, Usage>& usage, ostream& out){
+    vector<pair<string, Usage>> sorted(usage.begin(), usage.end());
+    stable_sort(sorted.begin(), sorted.end(), [](const pair<string, Usage>& first, const pair<string, Usage>& second) -> bool {
+        return first.second.bytes > second.second.bytes;
+    });
+    for (auto& entry : sorted){
+        out << category << " " << entry.first << " " << entry.second.count << " " << entry.second.bytes << "\n";
+    }
+}
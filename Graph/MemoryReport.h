@@ -0,0 +1,107 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// MemoryReport.h
+//
+// Breaks down how much memory a graph holds by node type,
+// edge type, attribute key, string storage and indexes.
+// Sizes are estimated from the containers' contents and
+// the layout of libstdc++; allocator overhead is left out.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef ZELDA_MEMORYREPORT_H
+#define ZELDA_MEMORYREPORT_H
+
+#include <cstddef>
+#include <map>
+#include <set>
+#include <string>
+#include "../JSON/json.h"
+
+class MemoryReport {
+public:
+    //Tree nodes carry a colour and three links; hash nodes a link and a cached hash.
+    static const size_t TREE_NODE = 4 * sizeof(void*);
+    static const size_t HASH_NODE = 2 * sizeof(void*);
+
+    //Recording
+    void addNode(const std::string& type, size_t bytes);
+    void addEdge(const std::string& type, size_t bytes);
+    void addAttribute(const std::string& key, size_t bytes);
+    void addStrings(size_t bytes);
+    void addTable(const std::string& name, size_t bytes, size_t entries = 0);
+    template <typename Map> void addAttributes(const Map& attributes);
+
+    //Getters
+    size_t total() const;
+
+    //Output
+    Json::Value toJson() const;
+    std::string toString() const;
+
+    //Estimates
+    static size_t heapBytes(const std::string& str);
+    static size_t heapBytes(const std::set<std::string>& values);
+    static size_t heapBytes(bool) { return 0; }
+    static size_t heapBytes(int) { return 0; }
+    template <typename Map> static size_t hashTableBytes(const Map& table);
+    template <typename Tree> static size_t treeBytes(const Tree& tree);
+
+private:
+    struct Usage {
+        size_t count = 0;
+        size_t bytes = 0;
+    };
+
+    std::map<std::string, Usage> nodes;
+    std::map<std::string, Usage> edges;
+    std::map<std::string, Usage> attributes;
+    std::map<std::string, Usage> tables;
+    size_t strings = 0;
+
+    static Json::Value usageToJson(const std::map<std::string, Usage>& usage);
+    static void usageToString(const std::string& category, const std::map<std::string, Usage>& usage, std::ostream& out);
+};
+
+/**
+ * Adds every attribute in one of a node's or edge's attribute maps.
+ * @param attributes The attributes, by key.
+ */
+template <typename Map> void MemoryReport::addAttributes(const Map& attributes){
+    for (auto& entry : attributes){
+        addAttribute(entry.first, sizeof(typename Map::value_type) + TREE_NODE + heapBytes(entry.first) + heapBytes(entry.second));
+    }
+}
+
+/**
+ * Estimates the buckets and entries of an unordered container,
+ * not counting anything the entries point to.
+ * @param table The container.
+ * @return The bytes it holds.
+ */
+template <typename Map> size_t MemoryReport::hashTableBytes(const Map& table){
+    return table.bucket_count() * sizeof(void*) + table.size() * (sizeof(typename Map::value_type) + HASH_NODE);
+}
+
+/**
+ * Estimates the entries of an ordered container, not counting
+ * anything the entries point to.
+ * @param tree The container.
+ * @return The bytes it holds.
+ */
+template <typename Tree> size_t MemoryReport::treeBytes(const Tree& tree){
+    return tree.size() * (sizeof(typename Tree::value_type) + TREE_NODE);
+}
+
+#endif //ZELDA_MEMORYREPORT_H
@@ -0,0 +1,182 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// PhaseStats.cpp
+//
+// Measures wall time, CPU time and peak memory for each
+// phase of a run and writes them out as JSON.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <ctime>
+#include <fstream>
+#include <sys/resource.h>
+#include "PhaseStats.h"
+#include "TraceLog.h"
+
+using namespace std;
+
+mutex PhaseStats::lock;
+LockWaits::Site PhaseStats::waits("PhaseStats");
+bool PhaseStats::enabled = false;
+chrono::steady_clock::time_point PhaseStats::wallStart;
+double PhaseStats::cpuStart = 0;
+map<string, PhaseStats::Phase> PhaseStats::phases;
+vector<string> PhaseStats::order;
+map<string, Json::Value> PhaseStats::sections;
+
+/**
+ * Starts timing a phase. CPU time and memory are only read if stats
+ * are enabled.
+ * @param phase The phase name.
+ * @param detail Extra text for the trace, such as the file being parsed.
+ */
+PhaseStats::Timer::Timer(const string& phase, const string& detail) : phase(phase), detail(detail), running(true),
+        measured(PhaseStats::isEnabled()), traced(TraceLog::isEnabled()), cpuStart(0), rssStart(0), traceStart(0) {
+    if (traced) traceStart = TraceLog::now();
+    if (measured){
+        rssStart = peakRSS();
+        cpuStart = cpuSeconds();
+    }
+    wallStart = chrono::steady_clock::now();
+}
+
+/**
+ * Records the phase if it was not stopped already.
+ */
+PhaseStats::Timer::~Timer(){
+    stop();
+}
+
+/**
+ * Records the phase. Later calls do nothing.
+ * @return The wall time of the phase in seconds, or zero if it was already stopped.
+ */
+double PhaseStats::Timer::stop(){
+    if (!running) return 0;
+    running = false;
+    double wall = chrono::duration<double>(chrono::steady_clock::now() - wallStart).count();
+    if (traced) TraceLog::complete(phase, "phase", traceStart, detail);
+    if (measured) record(phase, wall, cpuSeconds() - cpuStart, rssStart, peakRSS());
+    return wall;
+}
+
+/**
+ * Turns measuring on or off. Turning it on starts the run's totals.
+ * @param enabled Whether phases are measured.
+ */
+void PhaseStats::setEnabled(bool enabled){
+    LockWaits::Guard guard(lock, waits);
+    PhaseStats::enabled = enabled;
+    if (!enabled) return;
+    wallStart = chrono::steady_clock::now();
+    cpuStart = cpuSeconds();
+}
+
+/**
+ * Checks whether phases are measured.
+ * @return Whether stats are enabled.
+ */
+bool PhaseStats::isEnabled(){
+    LockWaits::Guard guard(lock, waits);
+    return enabled;
+}
+
+/**
+ * Adds one run of a phase to its totals.
+ * @param phase The phase name.
+ * @param wall The wall time, in seconds.
+ * @param cpu The CPU time of the whole process, in seconds.
+ * @param rssStart The peak resident set size when the phase started, in KB.
+ * @param rssEnd The peak resident set size when the phase ended, in KB.
+ */
+void PhaseStats::record(const string& phase, double wall, double cpu, long rssStart, long rssEnd){
+    LockWaits::Guard guard(lock, waits);
+    auto it = phases.find(phase);
+    if (it == phases.end()){
+        it = phases.insert(make_pair(phase, Phase())).first;
+        order.push_back(phase);
+    }
+
+    Phase& cur = it->second;
+    cur.calls++;
+    cur.wall += wall;
+    cur.cpu += cpu;
+    cur.peak = max(cur.peak, rssEnd);
+    cur.growth += rssEnd - rssStart;
+}
+
+/**
+ * Adds a report from elsewhere to the saved stats, replacing one of the same name.
+ * @param name The key it is saved under.
+ * @param value The report.
+ */
+void PhaseStats::setSection(const string& name, const Json::Value& value){
+    LockWaits::Guard guard(lock, waits);
+    sections[name] = value;
+}
+
+/**
+ * Saves the totals of every phase as JSON, in the order phases first ran.
+ * @param fileName The file to write.
+ * @return Boolean indicating success.
+ */
+bool PhaseStats::save(const string& fileName){
+    Json::Value root(Json::objectValue);
+    {
+        LockWaits::Guard guard(lock, waits);
+        root["wallSeconds"] = chrono::duration<double>(chrono::steady_clock::now() - wallStart).count();
+        root["cpuSeconds"] = cpuSeconds() - cpuStart;
+        root["peakRSSKB"] = Json::Int64(peakRSS());
+
+        Json::Value list(Json::arrayValue);
+        for (auto& name : order){
+            Phase& cur = phases[name];
+            Json::Value entry(Json::objectValue);
+            entry["name"] = name;
+            entry["calls"] = cur.calls;
+            entry["wallSeconds"] = cur.wall;
+            entry["cpuSeconds"] = cur.cpu;
+            entry["peakRSSKB"] = Json::Int64(cur.peak);
+            entry["peakGrowthKB"] = Json::Int64(cur.growth);
+            list.append(entry);
+        }
+        root["phases"] = list;
+        for (auto& section : sections) root[section.first] = section.second;
+    }
+
+    std::ofstream out(fileName);
+    if (!out.is_open()) return false;
+    out << root;
+    return out.good();
+}
+
+/**
+ * Gets the CPU time used by every thread of the process.
+ * @return The CPU time, in seconds.
+ */
+double PhaseStats::cpuSeconds(){
+    timespec now;
+    if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &now) != 0) return 0;
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+/**
+ * Gets the largest resident set size the process has reached.
+ * @return The peak resident set size, in KB.
+ */
+long PhaseStats::peakRSS(){
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+    return usage.ru_maxrss;
+}
@@ -0,0 +1,90 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// PhaseStats.h
+//
+// Measures wall time, CPU time and peak memory for each
+// phase of a run, so a slow or bloated phase can be told
+// apart from the rest. Nothing is measured unless stats
+// are enabled. Phases are also added to the trace when
+// tracing is on.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef ZELDA_PHASESTATS_H
+#define ZELDA_PHASESTATS_H
+
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "../JSON/json.h"
+#include "LockWaits.h"
+
+class PhaseStats {
+public:
+    //Measures one run of a phase, from construction until stop or destruction.
+    class Timer {
+    public:
+        explicit Timer(const std::string& phase, const std::string& detail = "");
+        ~Timer();
+        double stop();
+
+    private:
+        std::string phase;
+        std::string detail;
+        bool running;
+        bool measured;
+        bool traced;
+        std::chrono::steady_clock::time_point wallStart;
+        double cpuStart;
+        long rssStart;
+        long long traceStart;
+    };
+
+    //Settings
+    static void setEnabled(bool enabled);
+    static bool isEnabled();
+
+    //Recording
+    static void record(const std::string& phase, double wall, double cpu, long rssStart, long rssEnd);
+    static void setSection(const std::string& name, const Json::Value& value);
+
+    //Persistence
+    static bool save(const std::string& fileName);
+
+    //Process Counters
+    static double cpuSeconds();
+    static long peakRSS();
+
+private:
+    struct Phase {
+        int calls = 0;
+        double wall = 0;
+        double cpu = 0;
+        long peak = 0;                  //Process high-water mark when the phase last ended, in KB.
+        long growth = 0;                //How much the phase raised the high-water mark, in KB.
+    };
+
+    static std::mutex lock;
+    static LockWaits::Site waits;
+    static bool enabled;
+    static std::chrono::steady_clock::time_point wallStart;
+    static double cpuStart;
+    static std::map<std::string, Phase> phases;
+    static std::vector<std::string> order;
+    static std::map<std::string, Json::Value> sections;
+};
+
+#endif //ZELDA_PHASESTATS_H
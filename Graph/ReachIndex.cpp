@@ -0,0 +1,302 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ReachIndex.cpp
+//
+// Answers reachability questions over the call and
+// context graph without traversing it. The graph is
+// condensed into strongly connected components and
+// every component is given pruned landmark labels.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <numeric>
+#include "ReachIndex.h"
+
+using namespace std;
+
+/**
+ * Constructor that indexes a graph. The index describes the graph
+ * as it is now and must be rebuilt after the graph changes.
+ * @param graph The graph to index.
+ */
+ReachIndex::ReachIndex(TAGraph* graph){
+    build(graph);
+}
+
+/**
+ * Checks whether one node can reach another through calls, contexts
+ * and the throws a scope contains. Every node reaches itself.
+ * @param from The starting node.
+ * @param to The node to reach.
+ * @return Whether a path exists.
+ */
+bool ReachIndex::canReach(ZeldaNode* from, ZeldaNode* to){
+    if (from == to) return true;
+    int source = findVertex(from);
+    int target = findVertex(to);
+    if (source == -1 || target == -1) return false;
+    return reachesComponent(component[source], component[target]);
+}
+
+/**
+ * Checks whether an exception raised in a node can arrive at a catch.
+ * It can when the catch's try guards a path to the node; exceptions
+ * raised inside the try's own handlers leave through its parent instead.
+ * @param from The throw, or the function or scope it escapes from.
+ * @param handler The catch.
+ * @return Whether the exception may arrive at the catch.
+ */
+bool ReachIndex::canExceptionReach(ZeldaNode* from, ZeldaNode* handler){
+    if (!handler || handler->getType() != ZeldaNode::CATCH || !handler->getOwner()) return false;
+    int source = findVertex(from);
+    int guard = findVertex(handler->getOwner());
+    if (source == -1 || guard == -1) return false;
+
+    auto it = tryBodies.find(guard);
+    if (it == tryBodies.end()) return false;
+    for (int body : it->second){
+        if (body == source || reachesComponent(component[body], component[source])) return true;
+    }
+    return false;
+}
+
+/**
+ * Gets the number of strongly connected components that were labelled.
+ * @return The component count.
+ */
+int ReachIndex::getNumComponents(){
+    return (int) labelIn.size();
+}
+
+/**
+ * Gets the total number of landmark labels stored.
+ * @return The label count.
+ */
+long long ReachIndex::getNumLabels(){
+    long long total = 0;
+    for (int i = 0; i < labelIn.size(); i++) total += labelIn[i].size() + labelOut[i].size();
+    return total;
+}
+
+/**
+ * Reads the indexed edges, condenses them and labels the components.
+ * Only the throws a scope links to directly are indexed, so edges added
+ * by exception propagation do not create paths.
+ * @param graph The graph to index.
+ */
+void ReachIndex::build(TAGraph* graph){
+    const ZeldaEdge::EdgeType TYPES[] = {ZeldaEdge::CALLS, ZeldaEdge::VIRTUAL_CALL, ZeldaEdge::CONTEXT,
+                                         ZeldaEdge::THROWS, ZeldaEdge::RETHROWS};
+
+    vector<vector<int>> adjacency;
+    for (ZeldaEdge::EdgeType type : TYPES){
+        for (ZeldaEdge* edge : graph->findEdgesByType(type)){
+            ZeldaNode* src = edge->getSource();
+            ZeldaNode* dst = edge->getDestination();
+            if (!src || !dst) continue;
+            bool isThrow = type == ZeldaEdge::THROWS || type == ZeldaEdge::RETHROWS;
+            if (isThrow && dst->getScope() && dst->getScope() != src) continue;
+
+            int source = addVertex(src);
+            int target = addVertex(dst);
+            if (adjacency.size() < vertexIndex.size()) adjacency.resize(vertexIndex.size());
+            adjacency[source].push_back(target);
+
+            //A try guards everything it contains except its own handlers.
+            if (src->getType() == ZeldaNode::TRY && dst->getOwner() != src) tryBodies[source].push_back(target);
+        }
+    }
+
+    int count = condense(adjacency);
+    vector<vector<int>> dag(count);
+    for (int vertex = 0; vertex < adjacency.size(); vertex++){
+        for (int next : adjacency[vertex]){
+            if (component[vertex] != component[next]) dag[component[vertex]].push_back(component[next]);
+        }
+    }
+    adjacency = vector<vector<int>>();
+    for (auto& successors : dag){
+        sort(successors.begin(), successors.end());
+        successors.erase(unique(successors.begin(), successors.end()), successors.end());
+    }
+
+    label(dag);
+}
+
+/**
+ * Numbers a node the first time it is seen.
+ * @param node The node.
+ * @return Its vertex number.
+ */
+int ReachIndex::addVertex(ZeldaNode* node){
+    auto it = vertexIndex.find(node);
+    if (it != vertexIndex.end()) return it->second;
+    int vertex = (int) vertexIndex.size();
+    vertexIndex[node] = vertex;
+    return vertex;
+}
+
+/**
+ * Condenses the vertices into strongly connected components. A
+ * component is numbered after every component it reaches.
+ * @param adjacency The successors of each vertex.
+ * @return The number of components.
+ */
+int ReachIndex::condense(const vector<vector<int>>& adjacency){
+    int count = (int) adjacency.size();
+    vector<int> index(count, -1);
+    vector<int> low(count, 0);
+    vector<bool> onStack(count, false);
+    vector<int> stack;
+    int next = 0;
+    int components = 0;
+    component.assign(count, -1);
+
+    //Iterative Tarjan so deep call chains do not exhaust the stack.
+    vector<pair<int, int>> frames;
+    for (int root = 0; root < count; root++){
+        if (index[root] != -1) continue;
+        frames.push_back(make_pair(root, 0));
+
+        while (!frames.empty()){
+            int cur = frames.back().first;
+            int& pos = frames.back().second;
+
+            if (pos == 0 && index[cur] == -1){
+                index[cur] = low[cur] = next++;
+                stack.push_back(cur);
+                onStack[cur] = true;
+            }
+
+            if (pos < adjacency[cur].size()){
+                int dep = adjacency[cur][pos++];
+                if (index[dep] == -1){
+                    frames.push_back(make_pair(dep, 0));
+                } else if (onStack[dep]){
+                    low[cur] = min(low[cur], index[dep]);
+                }
+                continue;
+            }
+
+            if (low[cur] == index[cur]){
+                int member;
+                do {
+                    member = stack.back();
+                    stack.pop_back();
+                    onStack[member] = false;
+                    component[member] = components;
+                } while (member != cur);
+                components++;
+            }
+
+            frames.pop_back();
+            if (!frames.empty()){
+                int caller = frames.back().first;
+                low[caller] = min(low[caller], low[cur]);
+            }
+        }
+    }
+    return components;
+}
+
+/**
+ * Gives every component its landmark labels. Landmarks are taken in
+ * order of how many paths they are likely to cover, and each search
+ * stops wherever the labels found so far already answer the query.
+ * @param dag The successors of each component.
+ */
+void ReachIndex::label(const vector<vector<int>>& dag){
+    int count = (int) dag.size();
+    vector<vector<int>> reverse(count);
+    for (int cur = 0; cur < count; cur++){
+        for (int next : dag[cur]) reverse[next].push_back(cur);
+    }
+
+    vector<int> order(count);
+    iota(order.begin(), order.end(), 0);
+    stable_sort(order.begin(), order.end(), [&](int first, int second) -> bool {
+        return (long long) (dag[first].size() + 1) * (reverse[first].size() + 1) >
+               (long long) (dag[second].size() + 1) * (reverse[second].size() + 1);
+    });
+
+    labelOut.assign(count, vector<int>());
+    labelIn.assign(count, vector<int>());
+    vector<int> seen(count, -1);
+    vector<int> queue;
+    for (int rank = 0; rank < count; rank++){
+        int landmark = order[rank];
+
+        //Components the landmark reaches.
+        queue.assign(1, landmark);
+        seen[landmark] = 2 * rank;
+        for (int i = 0; i < queue.size(); i++){
+            int cur = queue[i];
+            if (cur != landmark && reachesComponent(landmark, cur)) continue;
+            labelIn[cur].push_back(rank);
+            for (int next : dag[cur]){
+                if (seen[next] == 2 * rank) continue;
+                seen[next] = 2 * rank;
+                queue.push_back(next);
+            }
+        }
+
+        //Components that reach the landmark.
+        queue.assign(1, landmark);
+        seen[landmark] = 2 * rank + 1;
+        for (int i = 0; i < queue.size(); i++){
+            int cur = queue[i];
+            if (cur != landmark && reachesComponent(cur, landmark)) continue;
+            labelOut[cur].push_back(rank);
+            for (int next : reverse[cur]){
+                if (seen[next] == 2 * rank + 1) continue;
+                seen[next] = 2 * rank + 1;
+                queue.push_back(next);
+            }
+        }
+    }
+}
+
+/**
+ * Gets the vertex number of a node.
+ * @param node The node.
+ * @return The vertex, or -1 if the node is not indexed.
+ */
+int ReachIndex::findVertex(ZeldaNode* node){
+    auto it = vertexIndex.find(node);
+    return (it == vertexIndex.end()) ? -1 : it->second;
+}
+
+/**
+ * Checks whether one component reaches another using their labels.
+ * @param from The starting component.
+ * @param to The component to reach.
+ * @return Whether a path exists.
+ */
+bool ReachIndex::reachesComponent(int from, int to){
+    if (from == to) return true;
+
+    //Components only reach components numbered before them.
+    if (from < to) return false;
+
+    auto& out = labelOut[from];
+    auto& in = labelIn[to];
+    int i = 0, j = 0;
+    while (i < out.size() && j < in.size()){
+        if (out[i] == in[j]) return true;
+        if (out[i] < in[j]) i++;
+        else j++;
+    }
+    return false;
+}
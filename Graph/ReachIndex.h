@@ -0,0 +1,69 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ReachIndex.h
+//
+// Answers reachability questions over the call and
+// context graph without traversing it. The graph is
+// condensed into strongly connected components and
+// every component is given pruned landmark labels:
+// X reaches Y exactly when some landmark is both
+// reachable from X and able to reach Y, so a query is
+// a merge of two short sorted lists.
+//
+// Exception reachability is structural: it follows the
+// scopes an exception would unwind through but ignores
+// handler types. A negative answer is definitive; a
+// positive one means the exception may arrive.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef ZELDA_REACHINDEX_H
+#define ZELDA_REACHINDEX_H
+
+#include <unordered_map>
+#include <vector>
+#include "TAGraph.h"
+
+class ReachIndex {
+public:
+    //Constructor
+    explicit ReachIndex(TAGraph* graph);
+
+    //Queries
+    bool canReach(ZeldaNode* from, ZeldaNode* to);
+    bool canExceptionReach(ZeldaNode* from, ZeldaNode* handler);
+
+    //Statistics
+    int getNumComponents();
+    long long getNumLabels();
+
+private:
+    std::unordered_map<ZeldaNode*, int> vertexIndex;
+    std::vector<int> component;                     //Component of each vertex, in reverse topological order.
+    std::vector<std::vector<int>> labelOut;         //Landmarks each component reaches, by rank.
+    std::vector<std::vector<int>> labelIn;          //Landmarks that reach each component, by rank.
+    std::unordered_map<int, std::vector<int>> tryBodies;  //Vertices a try guards, without its handlers.
+
+    //Construction
+    void build(TAGraph* graph);
+    int addVertex(ZeldaNode* node);
+    int condense(const std::vector<std::vector<int>>& adjacency);
+    void label(const std::vector<std::vector<int>>& dag);
+
+    //Query Helpers
+    int findVertex(ZeldaNode* node);
+    bool reachesComponent(int from, int to);
+};
+
+#endif //ZELDA_REACHINDEX_H
@@ -26,10 +26,11 @@
 /////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 #include <iostream>
+#include <algorithm>
+#include <set>
 #include "MD5.h"
 #include <cstring>
 #include <assert.h>
-#include "../Walker/ZeldaWalker.h"
 #include "TAGraph.h"
 #include "ZeldaNode.h"
 #include "ZeldaEdge.h"
@@ -49,6 +50,7 @@ TAGraph::TAGraph(){
     idList = std::unordered_map<std::string, ZeldaNode*>();
     edgeSrcList = std::unordered_map<std::string, std::vector<ZeldaEdge*>>();
     edgeDstList = std::unordered_map<std::string, std::vector<ZeldaEdge*>>();
+    currentUnit = -1;
 }
 
 /**
@@ -73,19 +75,33 @@ void TAGraph::clearGraph(){
     }
     edgeSrcList.clear();
     edgeDstList.clear();
+    fileNodes.clear();
+    unitNodes.clear();
+    fileEdges.clear();
+    unitEdges.clear();
+    fileUnits.clear();
+    unitFiles.clear();
 }
 
 void TAGraph::emptyGraph(){
     idList.clear();
     edgeSrcList.clear();
     edgeDstList.clear();
+    fileNodes.clear();
+    unitNodes.clear();
+    fileEdges.clear();
+    unitEdges.clear();
+    fileUnits.clear();
+    unitFiles.clear();
 }
 
 void TAGraph::merge(TAGraph* other){
+  vector<pair<ZeldaNode*, ZeldaNode*>> linked;
   for ( auto elem : other->idList ){
     string ID = elem.first;
     ZeldaNode* node = elem.second;
     ZeldaNode* exists = findNode(ID);
+    linked.push_back(make_pair(( exists ) ? exists : node, node));
     // fix edges in this graph which contain node in other
     if ( exists ){
       // node exists and must be added
@@ -108,6 +124,7 @@ void TAGraph::merge(TAGraph* other){
       ZeldaNode* end = findNode(edge->getDestinationID());
       if ( end ) edge->setDestination(end);
       if ( exists ) edge->setSource(exists);
+      if ( isDuplicateDerived(edge) ) continue;
       addEdge(edge);
     }
     vector<ZeldaEdge*> dest = other->findEdgesByDst(ID);
@@ -115,13 +132,151 @@ void TAGraph::merge(TAGraph* other){
       ZeldaNode* begin = findNode(edge->getSourceID());
       if ( begin ) edge->setSource(begin);
       if ( exists ) edge->setDestination(exists);
+      if ( isDuplicateDerived(edge) ) continue;
       addEdge(edge);
     }
     //if ( exists && node != exists ) delete node;
   }
+  // point try/catch/throw links at the nodes kept in this graph
+  for ( auto entry : linked ){
+    relinkNode(entry.first, entry.second);
+  }
   other->emptyGraph();
 }
 
+/**
+ * Checks whether an edge derived by exception propagation is already in
+ * the graph. Every unit including a header resolves the header's local
+ * throws again, so merging would otherwise repeat their paths and catches.
+ * @param edge The edge being merged in.
+ * @return Whether an equal derived edge exists.
+ */
+bool TAGraph::isDuplicateDerived(ZeldaEdge* edge){
+  if ( edge->getType() != ZeldaEdge::THROWPATH && edge->getType() != ZeldaEdge::CATCHES ) return false;
+  return doesEdgeExist(edge->getSourceID(), edge->getDestinationID(), edge->getType());
+}
+
+/**
+ * Copies the structural links of a merged node, resolving each
+ * linked node to the copy kept in this graph.
+ * @param node The node kept in this graph.
+ * @param from The node that was merged in.
+ */
+void TAGraph::relinkNode(ZeldaNode* node, ZeldaNode* from){
+  bool replace = ( node == from );
+  if ( from->getScope() && (replace || !node->getScope()) ){
+    node->setScope(findNode(from->getScope()->getID()));
+  }
+  if ( from->getOwner() && (replace || !node->getOwner()) ){
+    node->setOwner(findNode(from->getOwner()->getID()));
+  }
+
+  vector<ZeldaNode*> handlers = from->getHandlers();
+  if ( replace ) node->clearHandlers();
+  for ( auto handler : handlers ){
+    ZeldaNode* cur = findNode(handler->getID());
+    if ( cur ) node->addHandler(cur);
+  }
+}
+
+/**
+ * Records a node under its file and unit.
+ * @param node The node to index.
+ */
+void TAGraph::indexNode(ZeldaNode* node){
+    if (node->getFileID() != -1) fileNodes[node->getFileID()].insert(node);
+    if (node->getUnitID() != -1) unitNodes[node->getUnitID()].insert(node);
+    if (node->getFileID() != -1 && node->getUnitID() != -1){
+        fileUnits[node->getFileID()].insert(node->getUnitID());
+        unitFiles[node->getUnitID()].insert(node->getFileID());
+    }
+}
+
+/**
+ * Drops a node from the file and unit indices.
+ * @param node The node to drop.
+ */
+void TAGraph::unindexNode(ZeldaNode* node){
+    auto file = fileNodes.find(node->getFileID());
+    if (file != fileNodes.end()){
+        file->second.erase(node);
+        if (file->second.empty()) fileNodes.erase(file);
+    }
+    auto unit = unitNodes.find(node->getUnitID());
+    if (unit != unitNodes.end()){
+        unit->second.erase(node);
+        if (unit->second.empty()) unitNodes.erase(unit);
+    }
+}
+
+/**
+ * Records an edge under its file and unit.
+ * @param edge The edge to index.
+ */
+void TAGraph::indexEdge(ZeldaEdge* edge){
+    if (edge->getFileID() != -1) fileEdges[edge->getFileID()].insert(edge);
+    if (edge->getUnitID() != -1) unitEdges[edge->getUnitID()].insert(edge);
+    if (edge->getFileID() != -1 && edge->getUnitID() != -1){
+        fileUnits[edge->getFileID()].insert(edge->getUnitID());
+        unitFiles[edge->getUnitID()].insert(edge->getFileID());
+    }
+}
+
+/**
+ * Drops an edge from the file and unit indices.
+ * @param edge The edge to drop.
+ */
+void TAGraph::unindexEdge(ZeldaEdge* edge){
+    auto file = fileEdges.find(edge->getFileID());
+    if (file != fileEdges.end()){
+        file->second.erase(edge);
+        if (file->second.empty()) fileEdges.erase(file);
+    }
+    auto unit = unitEdges.find(edge->getUnitID());
+    if (unit != unitEdges.end()){
+        unit->second.erase(edge);
+        if (unit->second.empty()) unitEdges.erase(unit);
+    }
+}
+
+/**
+ * Removes a set of facts. Edges are removed first so that only
+ * edges contributed by other files are left pointing at the nodes,
+ * and those fall back to the IDs they store. Try, catch and throw
+ * links are lexical and never cross a file, so they go with the nodes.
+ * @param nodes The nodes to remove.
+ * @param edges The edges to remove.
+ * @return The number of facts removed.
+ */
+int TAGraph::retract(unordered_set<ZeldaNode*> nodes, unordered_set<ZeldaEdge*> edges){
+    for (auto edge : edges){
+        removeEdge(edge);
+    }
+
+    for (auto node : nodes){
+        string ID = node->getID();
+        auto entry = idList.find(ID);
+        if (entry != idList.end() && entry->second == node) idList.erase(entry);
+        unindexNode(node);
+
+        auto srcs = edgeSrcList.find(ID);
+        if (srcs != edgeSrcList.end()){
+            for (auto edge : srcs->second){
+                if (edge->getSource() == node) edge->setSource(nullptr);
+            }
+        }
+        auto dsts = edgeDstList.find(ID);
+        if (dsts != edgeDstList.end()){
+            for (auto edge : dsts->second){
+                if (edge->getDestination() == node) edge->setDestination(nullptr);
+            }
+        }
+        delete node;
+    }
+
+    return (int) (nodes.size() + edges.size());
+}
+
 /**
  * Checks if the graph is empty.
  * @return Whether the graph is empty.
@@ -140,10 +295,18 @@ void TAGraph::addNode(ZeldaNode* node){
     string newID = node->getID();
     node->setID(newID);
 
-    //Add the node.
-    if (idList.find(node->getID()) != idList.end())
+    //Add the node. A replaced node no longer contributes any facts.
+    auto existing = idList.find(node->getID());
+    if (existing != idList.end()){
         assert("Entry already exists.");
+        if (existing->second != node) unindexNode(existing->second);
+    }
     idList[node->getID()] = node;
+
+    //Stamp the unit being walked.
+    if (node->getUnitID() == -1) node->setUnitID(currentUnit);
+    if (node->getFileID() == -1) node->setFileID(currentUnit);
+    indexNode(node);
 }
 
 /**
@@ -151,14 +314,89 @@ void TAGraph::addNode(ZeldaNode* node){
  * @param edge  The edge to add.
  */
 void TAGraph::addEdge(ZeldaEdge* edge){
+    stampEdge(edge);
+    edgeSrcList[edge->getSourceID()].push_back(edge);
+    edgeDstList[edge->getDestinationID()].push_back(edge);
+    indexEdge(edge);
+}
+
+/**
+ * Gives an edge its hashed IDs and its provenance. Only the edge is
+ * modified, so any number of edges can be stamped at once.
+ * @param edge The edge to stamp.
+ */
+void TAGraph::stampEdge(ZeldaEdge* edge){
     //Convert the edge to a hash version.
     edge->setSourceID(edge->getSourceID());
     edge->setDestinationID(edge->getDestinationID());
 
-    edgeSrcList[edge->getSourceID()].push_back(edge);
-    edgeDstList[edge->getDestinationID()].push_back(edge);
+    //Edges come from the file of their source, falling back to the unit being walked.
+    if (edge->getUnitID() == -1) edge->setUnitID(currentUnit);
+    if (edge->getFileID() == -1){
+        int fileID = currentUnit;
+        if (edge->getSource() && edge->getSource()->getFileID() != -1){
+            fileID = edge->getSource()->getFileID();
+        } else if (edge->getDestination() && edge->getDestination()->getFileID() != -1){
+            fileID = edge->getDestination()->getFileID();
+        }
+        edge->setFileID(fileID);
+    }
+}
+
+/**
+ * Makes room for stamped edges between some nodes to be added by
+ * several threads. Afterwards appendBySource, appendByDestination and
+ * indexByFile may run concurrently for edges of different sources,
+ * destinations and files respectively, as long as nothing else
+ * changes the graph.
+ * @param sources The nodes the edges start at.
+ * @param destinations The nodes the edges end at.
+ */
+void TAGraph::reserveEdges(const vector<ZeldaNode*>& sources, const vector<ZeldaNode*>& destinations){
+    for (ZeldaNode* node : sources){
+        edgeSrcList[node->getID()];
+        if (node->getFileID() != -1) fileEdges[node->getFileID()];
+    }
+    for (ZeldaNode* node : destinations){
+        edgeDstList[node->getID()];
+        if (node->getFileID() != -1) fileEdges[node->getFileID()];
+    }
+    if (currentUnit != -1) fileEdges[currentUnit];
 }
 
+/**
+ * Adds a stamped edge to the edges of its source.
+ * @param edge The edge, whose source was reserved.
+ */
+void TAGraph::appendBySource(ZeldaEdge* edge){
+    edgeSrcList.find(edge->getSourceID())->second.push_back(edge);
+}
+
+/**
+ * Adds a stamped edge to the edges of its destination.
+ * @param edge The edge, whose destination was reserved.
+ */
+void TAGraph::appendByDestination(ZeldaEdge* edge){
+    edgeDstList.find(edge->getDestinationID())->second.push_back(edge);
+}
+
+/**
+ * Records a stamped edge under its file and unit. Edges of one file
+ * share a set, so each file must be indexed by one thread.
+ * @param edge The edge, whose file was reserved.
+ */
+void TAGraph::indexByFile(ZeldaEdge* edge){
+    if (edge->getFileID() != -1) fileEdges.find(edge->getFileID())->second.insert(edge);
+    if (edge->getUnitID() == -1) return;
+
+    //Every new edge carries the same unit, so its indices are shared by all threads.
+    lock_guard<mutex> guard(unitLock);
+    unitEdges[edge->getUnitID()].insert(edge);
+    if (edge->getFileID() != -1){
+        fileUnits[edge->getFileID()].insert(edge->getUnitID());
+        unitFiles[edge->getUnitID()].insert(edge->getFileID());
+    }
+}
 
 /**
  * Removes a node.
@@ -169,9 +407,9 @@ void TAGraph::removeNode(std::string nodeID){
 
     //Erase the node.
     idList.erase(nodeID);
-    delete node;
+    if (node) unindexNode(node);
 
-    //Erase all pertinent edges.
+    //Erase all pertinent edges. Edges read their IDs through the node, so it goes last.
     vector<ZeldaEdge*> srcs = findEdgesBySrc(nodeID);
     vector<ZeldaEdge*> dsts = findEdgesByDst(nodeID);
     for (auto &item : srcs){
@@ -180,6 +418,7 @@ void TAGraph::removeNode(std::string nodeID){
     for (auto &item : dsts){
         removeEdge(item->getSourceID(), item->getDestinationID(), item->getType(), true);
     }
+    delete node;
 }
 
 /**
@@ -199,7 +438,7 @@ void TAGraph::removeEdge(std::string srcID, std::string dstID, ZeldaEdge::EdgeTy
 
     //Starts by finding the node in the source list.
     vector<ZeldaEdge*> srcEdges = edgeSrcList[srcID];
-    for (int i = 0; srcEdges.size(); i++){
+    for (int i = 0; i < srcEdges.size(); i++){
         ZeldaEdge* edge = srcEdges.at(i);
         if (edge->getSourceID().compare(srcID) == 0 && edge->getDestinationID().compare(dstID) == 0 &&
                 edge->getType() == type){
@@ -211,7 +450,7 @@ void TAGraph::removeEdge(std::string srcID, std::string dstID, ZeldaEdge::EdgeTy
 
     //Removes the node in the destination list.
     vector<ZeldaEdge*> dstEdges = edgeDstList[dstID];
-    for (int i = 0; dstEdges.size(); i++){
+    for (int i = 0; i < dstEdges.size(); i++){
         ZeldaEdge* edge = dstEdges.at(i);
         if (edge->getSourceID().compare(srcID) == 0 && edge->getDestinationID().compare(dstID) == 0 &&
             edge->getType() == type){
@@ -221,7 +460,182 @@ void TAGraph::removeEdge(std::string srcID, std::string dstID, ZeldaEdge::EdgeTy
     }
 
     //Removes the edge.
-    if (edgeToRemove) delete edgeToRemove;
+    if (edgeToRemove){
+        unindexEdge(edgeToRemove);
+        delete edgeToRemove;
+    }
+}
+
+/**
+ * Removes a specific edge, including any duplicate entries of it.
+ * @param edge The edge to remove.
+ */
+void TAGraph::removeEdge(ZeldaEdge* edge){
+    auto src = edgeSrcList.find(edge->getSourceID());
+    if (src != edgeSrcList.end()){
+        src->second.erase(std::remove(src->second.begin(), src->second.end(), edge), src->second.end());
+    }
+    auto dst = edgeDstList.find(edge->getDestinationID());
+    if (dst != edgeDstList.end()){
+        dst->second.erase(std::remove(dst->second.begin(), dst->second.end(), edge), dst->second.end());
+    }
+
+    unindexEdge(edge);
+    delete edge;
+}
+
+/**
+ * Sets the translation unit being walked. Nodes and edges added
+ * without provenance are stamped with it.
+ * @param unitID The interned file ID of the unit, or -1 for none.
+ */
+void TAGraph::setCurrentUnit(int unitID){
+    currentUnit = unitID;
+}
+
+/**
+ * Gets the translation unit being walked.
+ * @return The interned file ID of the unit, or -1 for none.
+ */
+int TAGraph::getCurrentUnit(){
+    return currentUnit;
+}
+
+/**
+ * Removes every node and edge recorded from a file. Edges from
+ * other files that point at removed nodes are kept unestablished
+ * so they resolve again once the file is walked again.
+ * @param fileID The interned file ID.
+ * @return The number of facts removed.
+ */
+int TAGraph::retractFile(int fileID){
+    auto nodes = fileNodes.find(fileID);
+    auto edges = fileEdges.find(fileID);
+    return retract((nodes == fileNodes.end()) ? unordered_set<ZeldaNode*>() : nodes->second,
+                   (edges == fileEdges.end()) ? unordered_set<ZeldaEdge*>() : edges->second);
+}
+
+/**
+ * Removes every node and edge recorded while walking a translation
+ * unit, including facts from the headers it included.
+ * @param unitID The interned file ID of the unit.
+ * @return The number of facts removed.
+ */
+int TAGraph::retractUnit(int unitID){
+    auto files = unitFiles.find(unitID);
+    if (files != unitFiles.end()){
+        for (int fileID : files->second) fileUnits[fileID].erase(unitID);
+        unitFiles.erase(files);
+    }
+
+    auto nodes = unitNodes.find(unitID);
+    auto edges = unitEdges.find(unitID);
+    return retract((nodes == unitNodes.end()) ? unordered_set<ZeldaNode*>() : nodes->second,
+                   (edges == unitEdges.end()) ? unordered_set<ZeldaEdge*>() : edges->second);
+}
+
+/**
+ * Finds the nodes recorded from a file.
+ * @param fileID The interned file ID.
+ * @return The nodes of the file.
+ */
+vector<ZeldaNode*> TAGraph::findNodesByFile(int fileID){
+    auto it = fileNodes.find(fileID);
+    if (it == fileNodes.end()) return vector<ZeldaNode*>();
+    return vector<ZeldaNode*>(it->second.begin(), it->second.end());
+}
+
+/**
+ * Finds the nodes recorded while walking a translation unit.
+ * @param unitID The interned file ID of the unit.
+ * @return The nodes of the unit.
+ */
+vector<ZeldaNode*> TAGraph::findNodesByUnit(int unitID){
+    auto it = unitNodes.find(unitID);
+    if (it == unitNodes.end()) return vector<ZeldaNode*>();
+    return vector<ZeldaNode*>(it->second.begin(), it->second.end());
+}
+
+/**
+ * Finds the translation units whose walk recorded facts from a file.
+ * Units count even if a later unit replaced the nodes they recorded.
+ * @param fileID The interned file ID.
+ * @return The unit IDs in ascending order.
+ */
+vector<int> TAGraph::findUnitsByFile(int fileID){
+    auto it = fileUnits.find(fileID);
+    if (it == fileUnits.end()) return vector<int>();
+    return vector<int>(it->second.begin(), it->second.end());
+}
+
+/**
+ * Counts the nodes recorded while walking a translation unit.
+ * @param unitID The interned file ID of the unit.
+ * @return The number of nodes the unit still owns.
+ */
+int TAGraph::countNodesByUnit(int unitID){
+    auto it = unitNodes.find(unitID);
+    return (it == unitNodes.end()) ? 0 : (int) it->second.size();
+}
+
+/**
+ * Counts the edges recorded while walking a translation unit.
+ * @param unitID The interned file ID of the unit.
+ * @return The number of edges the unit still owns.
+ */
+int TAGraph::countEdgesByUnit(int unitID){
+    auto it = unitEdges.find(unitID);
+    return (it == unitEdges.end()) ? 0 : (int) it->second.size();
+}
+
+/**
+ * Estimates the memory the graph holds, broken down by node type,
+ * edge type, attribute key, string storage and index.
+ * @return The report.
+ */
+MemoryReport TAGraph::memoryReport(){
+    MemoryReport report;
+    for (auto& entry : idList){
+        entry.second->addMemory(report);
+        report.addStrings(MemoryReport::heapBytes(entry.first));
+    }
+    report.addTable("idList", MemoryReport::hashTableBytes(idList), idList.size());
+
+    //Every edge is listed once under its source.
+    report.addTable("edgeSrcList", MemoryReport::hashTableBytes(edgeSrcList), edgeSrcList.size());
+    for (auto& entry : edgeSrcList){
+        for (auto edge : entry.second) edge->addMemory(report);
+        report.addStrings(MemoryReport::heapBytes(entry.first));
+        report.addTable("edgeSrcList", entry.second.capacity() * sizeof(ZeldaEdge*));
+    }
+    report.addTable("edgeDstList", MemoryReport::hashTableBytes(edgeDstList), edgeDstList.size());
+    for (auto& entry : edgeDstList){
+        report.addStrings(MemoryReport::heapBytes(entry.first));
+        report.addTable("edgeDstList", entry.second.capacity() * sizeof(ZeldaEdge*));
+    }
+
+    //Provenance indexes.
+    addIndexMemory(report, "fileNodes", fileNodes);
+    addIndexMemory(report, "unitNodes", unitNodes);
+    addIndexMemory(report, "fileEdges", fileEdges);
+    addIndexMemory(report, "unitEdges", unitEdges);
+    report.addTable("fileUnits", MemoryReport::hashTableBytes(fileUnits), fileUnits.size());
+    for (auto& entry : fileUnits) report.addTable("fileUnits", MemoryReport::treeBytes(entry.second));
+    report.addTable("unitFiles", MemoryReport::hashTableBytes(unitFiles), unitFiles.size());
+    for (auto& entry : unitFiles) report.addTable("unitFiles", MemoryReport::treeBytes(entry.second));
+    return report;
+}
+
+/**
+ * Adds a provenance index of node or edge sets to a memory report.
+ * @param report The report to add to.
+ * @param name The index name.
+ * @param index The index.
+ */
+template <typename Element> void TAGraph::addIndexMemory(MemoryReport& report, const string& name,
+        const unordered_map<int, unordered_set<Element*>>& index){
+    report.addTable(name, MemoryReport::hashTableBytes(index), index.size());
+    for (auto& entry : index) report.addTable(name, MemoryReport::hashTableBytes(entry.second));
 }
 
 /**
@@ -288,6 +702,24 @@ vector<ZeldaNode*> TAGraph::findNodesByType(ZeldaNode::NodeType type){
     return nodes;
 }
 
+/**
+ * Finds every edge of a type. Edges listed more than once are returned once.
+ * @param type The edge type.
+ * @return The edges of that type.
+ */
+vector<ZeldaEdge*> TAGraph::findEdgesByType(ZeldaEdge::EdgeType type){
+    vector<ZeldaEdge*> edges;
+    unordered_set<ZeldaEdge*> seen;
+
+    for (auto &entry : edgeSrcList){
+        for (auto edge : entry.second){
+            if (edge->getType() == type && seen.insert(edge).second) edges.push_back(edge);
+        }
+    }
+
+    return edges;
+}
+
 /**
  * Find edge bashed on its IDs.
  * @param srcID The source node ID.
@@ -489,7 +921,9 @@ bool TAGraph::keepFeatures(vector<string> features){
  * @return The string representation of the model.
  */
 bool TAGraph::getTAModel(const string& filename){
-    if ( ! out.is_open() ) out.open(filename);
+    //Each call rewrites the model from scratch.
+    if ( out.is_open() ) out.close();
+    out.open(filename);
     out << "// Zelda Exception Extraction \n//Author: Kirsten Bradley \n";
     
     out << "SCHEME TUPLE :\n\n";
@@ -501,6 +935,7 @@ bool TAGraph::getTAModel(const string& filename){
     generateRelations();
     out << "\nFACT ATTRIBUTE :\n";
     generateAttributes();
+    out.close();
 
     return true;
 }
@@ -28,12 +28,16 @@
 #ifndef ZELDA_TAGRAPH_H
 #define ZELDA_TAGRAPH_H
 
+#include <mutex>
 #include <unordered_map>
+#include <unordered_set>
+#include <set>
 #include <string>
 #include <vector>
 #include <fstream>
 #include "ZeldaEdge.h"
 #include "ZeldaNode.h"
+#include "MemoryReport.h"
 
 class TAGraph {
 public:
@@ -49,16 +53,36 @@ public:
     virtual void addNode(ZeldaNode* node);
     virtual void addEdge(ZeldaEdge* edge);
 
+    //Concurrent Edge Adders
+    void stampEdge(ZeldaEdge* edge);
+    void reserveEdges(const std::vector<ZeldaNode*>& sources, const std::vector<ZeldaNode*>& destinations);
+    void appendBySource(ZeldaEdge* edge);
+    void appendByDestination(ZeldaEdge* edge);
+    void indexByFile(ZeldaEdge* edge);
+
     //Node/Edge Removers
     //void hierarchyRemove(ZeldaNode* toRemove);
     void removeNode(std::string nodeID);
     void removeEdge(std::string srcID, std::string dstID, ZeldaEdge::EdgeType type, bool hashed = false);
+    void removeEdge(ZeldaEdge* edge);
+
+    //Provenance
+    void setCurrentUnit(int unitID);
+    int getCurrentUnit();
+    int retractFile(int fileID);
+    int retractUnit(int unitID);
+    std::vector<ZeldaNode*> findNodesByFile(int fileID);
+    std::vector<ZeldaNode*> findNodesByUnit(int unitID);
+    std::vector<int> findUnitsByFile(int fileID);
+    int countNodesByUnit(int unitID);
+    int countEdgesByUnit(int unitID);
 
     //Find Methods
     ZeldaNode* findNode(std::string nodeID);
     ZeldaNode* findNodeByName(std::string nodeName, bool MD5Check = false);
     ZeldaNode* findNodeByEndName(std::string endName, bool MD5Check = false);
     std::vector<ZeldaNode*> findNodesByType(ZeldaNode::NodeType type);
+    std::vector<ZeldaEdge*> findEdgesByType(ZeldaEdge::EdgeType type);
     ZeldaEdge* findEdge(std::string srcID, std::string dstID, ZeldaEdge::EdgeType type);
     std::vector<ZeldaEdge*> findEdgesBySrc(std::string srcID, bool md5 = true);
     std::vector<ZeldaEdge*> findEdgesByDst(std::string dstID, bool md5 = true);
@@ -76,6 +100,9 @@ public:
 
     void merge(TAGraph* other);
 
+    //Memory Accounting
+    MemoryReport memoryReport();
+
     //TA Generators
     virtual bool getTAModel(const std::string&);
 
@@ -87,6 +114,16 @@ protected:
     std::unordered_map<std::string, std::vector<ZeldaEdge*>> edgeSrcList;
     std::unordered_map<std::string, std::vector<ZeldaEdge*>> edgeDstList;
 
+    //Facts contributed by each file and translation unit.
+    int currentUnit;
+    std::unordered_map<int, std::unordered_set<ZeldaNode*>> fileNodes;
+    std::unordered_map<int, std::unordered_set<ZeldaNode*>> unitNodes;
+    std::unordered_map<int, std::unordered_set<ZeldaEdge*>> fileEdges;
+    std::unordered_map<int, std::unordered_set<ZeldaEdge*>> unitEdges;
+    std::unordered_map<int, std::set<int>> fileUnits;
+    std::unordered_map<int, std::set<int>> unitFiles;
+    std::mutex unitLock;                //Guards the unit indices while edges are added concurrently.
+
     bool generateInstances();
     bool generateRelations();
     bool generateAttributes();
@@ -103,6 +140,19 @@ private:
     //Edge Resolvers
     bool resolveEdge(ZeldaEdge* edge);
     bool resolveEdgeByName(ZeldaEdge* edge);
+    void relinkNode(ZeldaNode* node, ZeldaNode* from);
+    bool isDuplicateDerived(ZeldaEdge* edge);
+
+    //Provenance Helpers
+    void indexNode(ZeldaNode* node);
+    void unindexNode(ZeldaNode* node);
+    void indexEdge(ZeldaEdge* edge);
+    void unindexEdge(ZeldaEdge* edge);
+    int retract(std::unordered_set<ZeldaNode*> nodes, std::unordered_set<ZeldaEdge*> edges);
+
+    //Memory Helpers
+    template <typename Element> static void addIndexMemory(MemoryReport& report, const std::string& name,
+            const std::unordered_map<int, std::unordered_set<Element*>>& index);
 
     void emptyGraph();
     std::ofstream out;
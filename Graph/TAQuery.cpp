@@ -0,0 +1,407 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// TAQuery.cpp
+//
+// Evaluates relational-algebra queries directly on the
+// in-memory graph, so the common grok-style questions can
+// be answered without exporting the TA model first.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <cctype>
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
+#include "TAQuery.h"
+
+using namespace std;
+
+namespace {
+    struct TupleHash {
+        size_t operator()(const TAQuery::Tuple& tuple) const {
+            return hash<ZeldaNode*>()(tuple.first) * 31 + hash<ZeldaNode*>()(tuple.second);
+        }
+    };
+    typedef unordered_set<TAQuery::Tuple, TupleHash> TupleSet;
+    typedef unordered_map<ZeldaNode*, vector<ZeldaNode*>> Successors;
+
+    //Hash index of a relation on its first column, used for joins.
+    Successors index(const TAQuery::Relation& relation){
+        Successors succ;
+        for (auto& tuple : relation.tuples) succ[tuple.first].push_back(tuple.second);
+        return succ;
+    }
+
+    const string SYMBOLS = "()[]|&-~+=.";
+    const char QUOTED = '"';
+}
+
+/**
+ * Prepares a query engine over a graph.
+ * @param graph The graph to query.
+ */
+TAQuery::TAQuery(TAGraph* graph) : graph(graph), pos(0) { }
+
+/**
+ * Gets the established edges of a type as a relation. Base relations
+ * are read once per engine.
+ * @param type The edge type.
+ * @return The relation.
+ */
+TAQuery::Relation TAQuery::edges(ZeldaEdge::EdgeType type){
+    auto it = baseRelations.find(type);
+    if (it != baseRelations.end()) return it->second;
+
+    vector<Tuple> tuples;
+    for (ZeldaEdge* edge : graph->findEdgesByType(type)){
+        if (edge->getSource() && edge->getDestination()) tuples.push_back(make_pair(edge->getSource(), edge->getDestination()));
+    }
+    return baseRelations[type] = dedupe(tuples);
+}
+
+/**
+ * Composes two relations with a hash join on the shared column.
+ * @param left The relation applied first.
+ * @param right The relation applied second.
+ * @return The pairs (x, z) with (x, y) in left and (y, z) in right.
+ */
+TAQuery::Relation TAQuery::compose(const Relation& left, const Relation& right){
+    Successors succ = index(right);
+    vector<Tuple> tuples;
+    for (auto& tuple : left.tuples){
+        auto it = succ.find(tuple.second);
+        if (it == succ.end()) continue;
+        for (ZeldaNode* end : it->second) tuples.push_back(make_pair(tuple.first, end));
+    }
+    return dedupe(tuples, left.isSet && right.isSet);
+}
+
+/**
+ * Computes the transitive closure with semi-naive evaluation: each
+ * round only extends the pairs found in the round before.
+ * @param relation The relation.
+ * @return The transitive closure.
+ */
+TAQuery::Relation TAQuery::closure(const Relation& relation){
+    Successors succ = index(relation);
+    TupleSet seen(relation.tuples.begin(), relation.tuples.end());
+    Relation result;
+    result.tuples = relation.tuples;
+    result.isSet = relation.isSet;
+
+    vector<Tuple> delta = relation.tuples;
+    while (!delta.empty()){
+        vector<Tuple> next;
+        for (auto& tuple : delta){
+            auto it = succ.find(tuple.second);
+            if (it == succ.end()) continue;
+            for (ZeldaNode* end : it->second){
+                Tuple found = make_pair(tuple.first, end);
+                if (!seen.insert(found).second) continue;
+                next.push_back(found);
+                result.tuples.push_back(found);
+            }
+        }
+        delta.swap(next);
+    }
+    return result;
+}
+
+/**
+ * Reverses every pair of a relation.
+ * @param relation The relation.
+ * @return The inverse relation.
+ */
+TAQuery::Relation TAQuery::inverse(const Relation& relation){
+    Relation result;
+    result.isSet = relation.isSet;
+    result.tuples.reserve(relation.tuples.size());
+    for (auto& tuple : relation.tuples) result.tuples.push_back(make_pair(tuple.second, tuple.first));
+    return result;
+}
+
+/**
+ * Unites two relations.
+ * @param left The first relation.
+ * @param right The second relation.
+ * @return The pairs in either relation.
+ */
+TAQuery::Relation TAQuery::unite(const Relation& left, const Relation& right){
+    vector<Tuple> tuples = left.tuples;
+    tuples.insert(tuples.end(), right.tuples.begin(), right.tuples.end());
+    return dedupe(tuples, left.isSet && right.isSet);
+}
+
+/**
+ * Intersects two relations.
+ * @param left The first relation.
+ * @param right The second relation.
+ * @return The pairs in both relations.
+ */
+TAQuery::Relation TAQuery::intersect(const Relation& left, const Relation& right){
+    TupleSet other(right.tuples.begin(), right.tuples.end());
+    Relation result;
+    result.isSet = left.isSet && right.isSet;
+    for (auto& tuple : left.tuples){
+        if (other.count(tuple)) result.tuples.push_back(tuple);
+    }
+    return result;
+}
+
+/**
+ * Subtracts one relation from another.
+ * @param left The relation to subtract from.
+ * @param right The relation to subtract.
+ * @return The pairs of left that are not in right.
+ */
+TAQuery::Relation TAQuery::subtract(const Relation& left, const Relation& right){
+    TupleSet other(right.tuples.begin(), right.tuples.end());
+    Relation result;
+    result.isSet = left.isSet;
+    for (auto& tuple : left.tuples){
+        if (!other.count(tuple)) result.tuples.push_back(tuple);
+    }
+    return result;
+}
+
+/**
+ * Projects a relation on its first column.
+ * @param relation The relation.
+ * @return The sources, as a set.
+ */
+TAQuery::Relation TAQuery::domain(const Relation& relation){
+    vector<Tuple> tuples;
+    for (auto& tuple : relation.tuples) tuples.push_back(make_pair(tuple.first, tuple.first));
+    return dedupe(tuples, true);
+}
+
+/**
+ * Projects a relation on its second column.
+ * @param relation The relation.
+ * @return The destinations, as a set.
+ */
+TAQuery::Relation TAQuery::range(const Relation& relation){
+    vector<Tuple> tuples;
+    for (auto& tuple : relation.tuples) tuples.push_back(make_pair(tuple.second, tuple.second));
+    return dedupe(tuples, true);
+}
+
+/**
+ * Keeps the pairs whose source or destination has a property.
+ * @param relation The relation.
+ * @param source Whether to test the source instead of the destination.
+ * @param key The node type, id, name or attribute to compare.
+ * @param value The value it must have.
+ * @return The selected pairs.
+ */
+TAQuery::Relation TAQuery::select(const Relation& relation, bool source, const string& key, const string& value){
+    Relation result;
+    result.isSet = relation.isSet;
+    for (auto& tuple : relation.tuples){
+        if (matches((source) ? tuple.first : tuple.second, key, value)) result.tuples.push_back(tuple);
+    }
+    return result;
+}
+
+/**
+ * Evaluates a query expression.
+ * @param expression The expression.
+ * @param result Receives the relation.
+ * @param error Receives a message if the expression is invalid.
+ * @return Whether the expression was evaluated.
+ */
+bool TAQuery::evaluate(const string& expression, Relation& result, string& error){
+    tokens = tokenize(expression);
+    pos = 0;
+    this->error.clear();
+
+    bool ok = parseUnion(result);
+    if (ok && pos < tokens.size()) ok = fail("unexpected '" + tokens[pos] + "'");
+    error = this->error;
+    return ok;
+}
+
+/**
+ * Converts a relation to ID pairs in a stable order.
+ * @param relation The relation.
+ * @return The sorted source and destination IDs.
+ */
+vector<pair<string, string>> TAQuery::toIDs(const Relation& relation){
+    vector<pair<string, string>> ids;
+    ids.reserve(relation.tuples.size());
+    for (auto& tuple : relation.tuples) ids.push_back(make_pair(tuple.first->getID(), tuple.second->getID()));
+    sort(ids.begin(), ids.end());
+    return ids;
+}
+
+/**
+ * Splits an expression into tokens. Quoted values keep their
+ * opening quote so they are never read as operators.
+ * @param expression The expression.
+ * @return The tokens.
+ */
+vector<string> TAQuery::tokenize(const string& expression){
+    vector<string> result;
+    for (int i = 0; i < expression.size();){
+        char c = expression[i];
+        if (isspace((unsigned char) c)){
+            i++;
+        } else if (c == QUOTED){
+            int end = (int) expression.find(QUOTED, i + 1);
+            if (end == (int) string::npos) end = (int) expression.size();
+            result.push_back(expression.substr(i, end - i));
+            i = end + 1;
+        } else if (SYMBOLS.find(c) != string::npos){
+            result.push_back(string(1, c));
+            i++;
+        } else {
+            int start = i;
+            while (i < expression.size() && !isspace((unsigned char) expression[i]) &&
+                   SYMBOLS.find(expression[i]) == string::npos && expression[i] != QUOTED) i++;
+            result.push_back(expression.substr(start, i - start));
+        }
+    }
+    return result;
+}
+
+bool TAQuery::parseUnion(Relation& result){
+    if (!parseIntersection(result)) return false;
+    while (pos < tokens.size()){
+        bool isUnion = accept("|");
+        if (!isUnion && !accept("-")) break;
+
+        Relation right;
+        if (!parseIntersection(right)) return false;
+        result = (isUnion) ? unite(result, right) : subtract(result, right);
+    }
+    return true;
+}
+
+bool TAQuery::parseIntersection(Relation& result){
+    if (!parseComposition(result)) return false;
+    while (accept("&")){
+        Relation right;
+        if (!parseComposition(right)) return false;
+        result = intersect(result, right);
+    }
+    return true;
+}
+
+bool TAQuery::parseComposition(Relation& result){
+    if (!parseUnary(result)) return false;
+    while (accept("o")){
+        Relation right;
+        if (!parseUnary(right)) return false;
+        result = compose(result, right);
+    }
+    return true;
+}
+
+bool TAQuery::parseUnary(Relation& result){
+    if (accept("~")){
+        if (!parseUnary(result)) return false;
+        result = inverse(result);
+        return true;
+    }
+    if (accept("dom")){
+        if (!parseUnary(result)) return false;
+        result = domain(result);
+        return true;
+    }
+    if (accept("rng")){
+        if (!parseUnary(result)) return false;
+        result = range(result);
+        return true;
+    }
+    return parsePostfix(result);
+}
+
+bool TAQuery::parsePostfix(Relation& result){
+    if (!parsePrimary(result)) return false;
+    while (true){
+        if (accept("+")){
+            result = closure(result);
+        } else if (accept("[")){
+            if (pos >= tokens.size() || (tokens[pos] != "src" && tokens[pos] != "dst")) return fail("expected src or dst");
+            bool source = tokens[pos++] == "src";
+            if (!accept(".") || pos >= tokens.size()) return fail("expected .key after src or dst");
+            string key = tokens[pos++];
+            if (!accept("=") || pos >= tokens.size()) return fail("expected =value in selection");
+            string value = tokens[pos++];
+            if (!value.empty() && value[0] == QUOTED) value.erase(0, 1);
+            if (!accept("]")) return fail("expected ]");
+            result = select(result, source, key, value);
+        } else {
+            return true;
+        }
+    }
+}
+
+bool TAQuery::parsePrimary(Relation& result){
+    if (accept("(")){
+        if (!parseUnion(result)) return false;
+        return accept(")") || fail("expected )");
+    }
+    if (pos >= tokens.size()) return fail("unexpected end of query");
+
+    string name = tokens[pos++];
+    for (int type = ZeldaEdge::CONTAINS; type <= ZeldaEdge::VIRTUAL_CALL; type++){
+        if (ZeldaEdge::typeToString((ZeldaEdge::EdgeType) type) != name) continue;
+        result = edges((ZeldaEdge::EdgeType) type);
+        return true;
+    }
+    return fail("unknown relation '" + name + "'");
+}
+
+bool TAQuery::accept(const string& token){
+    if (pos >= tokens.size() || tokens[pos] != token) return false;
+    pos++;
+    return true;
+}
+
+bool TAQuery::fail(const string& message){
+    if (error.empty()) error = message;
+    return false;
+}
+
+/**
+ * Builds a relation without repeated pairs, keeping the first order seen.
+ * @param tuples The pairs.
+ * @param isSet Whether the relation is a projected set.
+ * @return The relation.
+ */
+TAQuery::Relation TAQuery::dedupe(vector<Tuple> tuples, bool isSet){
+    TupleSet seen;
+    Relation result;
+    result.isSet = isSet;
+    for (auto& tuple : tuples){
+        if (seen.insert(tuple).second) result.tuples.push_back(tuple);
+    }
+    return result;
+}
+
+/**
+ * Checks a node property for a selection.
+ * @param node The node.
+ * @param key The node type, id, name or attribute to compare.
+ * @param value The value it must have.
+ * @return Whether the node matches.
+ */
+bool TAQuery::matches(ZeldaNode* node, const string& key, const string& value){
+    if (key == "type") return ZeldaNode::typeToString(node->getType()) == value;
+    if (key == "id") return node->getID() == value;
+    if (key == "name") return node->getName() == value;
+    return node->getSingleAttribute(key) == value;
+}
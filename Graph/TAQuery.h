@@ -0,0 +1,100 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// TAQuery.h
+//
+// Evaluates relational-algebra queries directly on the
+// in-memory graph, so the common grok-style questions can
+// be answered without exporting the TA model first.
+//
+// Expressions are built from edge types (call, contain,
+// throws, ...) with these operators, loosest first:
+//
+//     R | S    union              R - S    difference
+//     R & S    intersection
+//     R o S    composition
+//     ~R       inverse            dom R    rng R    projection
+//     R+       transitive closure R[src.key=value]  selection
+//
+// Selections compare src or dst against the node type, id,
+// name or a single attribute.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef ZELDA_TAQUERY_H
+#define ZELDA_TAQUERY_H
+
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+#include "TAGraph.h"
+
+class TAQuery {
+public:
+    typedef std::pair<ZeldaNode*, ZeldaNode*> Tuple;
+
+    //A set of node pairs. Projections are kept as identity pairs.
+    struct Relation {
+        std::vector<Tuple> tuples;
+        bool isSet = false;
+    };
+
+    //Constructor
+    explicit TAQuery(TAGraph* graph);
+
+    //Base Relations
+    Relation edges(ZeldaEdge::EdgeType type);
+
+    //Operators
+    static Relation compose(const Relation& left, const Relation& right);
+    static Relation closure(const Relation& relation);
+    static Relation inverse(const Relation& relation);
+    static Relation unite(const Relation& left, const Relation& right);
+    static Relation intersect(const Relation& left, const Relation& right);
+    static Relation subtract(const Relation& left, const Relation& right);
+    static Relation domain(const Relation& relation);
+    static Relation range(const Relation& relation);
+    static Relation select(const Relation& relation, bool source, const std::string& key, const std::string& value);
+
+    //Evaluator
+    bool evaluate(const std::string& expression, Relation& result, std::string& error);
+    static std::vector<std::pair<std::string, std::string>> toIDs(const Relation& relation);
+
+private:
+    TAGraph* graph;
+    std::map<ZeldaEdge::EdgeType, Relation> baseRelations;
+
+    //Parser State
+    std::vector<std::string> tokens;
+    int pos;
+    std::string error;
+
+    //Parser
+    static std::vector<std::string> tokenize(const std::string& expression);
+    bool parseUnion(Relation& result);
+    bool parseIntersection(Relation& result);
+    bool parseComposition(Relation& result);
+    bool parseUnary(Relation& result);
+    bool parsePostfix(Relation& result);
+    bool parsePrimary(Relation& result);
+    bool accept(const std::string& token);
+    bool fail(const std::string& message);
+
+    //Helpers
+    static Relation dedupe(std::vector<Tuple> tuples, bool isSet = false);
+    static bool matches(ZeldaNode* node, const std::string& key, const std::string& value);
+};
+
+#endif //ZELDA_TAQUERY_H
@@ -0,0 +1,131 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ThreadPool.cpp
+//
+// Small fixed-size worker pool used to spread independent
+// pieces of graph processing over several cores. The
+// calling thread takes part in every parallel loop as
+// worker zero.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "ThreadPool.h"
+#include "TraceLog.h"
+
+using namespace std;
+
+/**
+ * Starts the pool.
+ * @param workers The number of workers, including the caller. Zero uses every core.
+ */
+ThreadPool::ThreadPool(int workers) : task(nullptr), next(0), count(0), active(0), generation(0), stopping(false) {
+    if (workers <= 0) workers = defaultWorkers();
+    for (int i = 1; i < workers; i++){
+        threads.push_back(thread(&ThreadPool::work, this, i));
+    }
+}
+
+/**
+ * Destructor. Stops and joins every worker.
+ */
+ThreadPool::~ThreadPool(){
+    {
+        lock_guard<mutex> guard(lock);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& worker : threads) worker.join();
+}
+
+/**
+ * Gets the number of workers, including the calling thread.
+ * @return The worker count.
+ */
+int ThreadPool::getNumWorkers(){
+    return (int) threads.size() + 1;
+}
+
+/**
+ * Gets the number of workers to use when none is given.
+ * @return The number of hardware threads, or one if unknown.
+ */
+int ThreadPool::defaultWorkers(){
+    unsigned int cores = thread::hardware_concurrency();
+    return (cores == 0) ? 1 : (int) cores;
+}
+
+/**
+ * Runs a task for every index in [0, count) and waits for all of them.
+ * @param count The number of indices.
+ * @param task The task, called with the index and the worker number.
+ */
+void ThreadPool::parallelFor(int count, const function<void(int, int)>& task){
+    if (count <= 0) return;
+    if (threads.empty() || count == 1){
+        for (int i = 0; i < count; i++) task(i, 0);
+        return;
+    }
+
+    {
+        lock_guard<mutex> guard(lock);
+        this->task = &task;
+        this->count = count;
+        next = 0;
+        active = (int) threads.size();
+        generation++;
+    }
+    wake.notify_all();
+
+    runTasks(0);
+
+    unique_lock<mutex> guard(lock);
+    done.wait(guard, [this]{ return active == 0; });
+    this->task = nullptr;
+}
+
+/**
+ * Worker loop. Sleeps until a new parallel loop starts.
+ * @param worker The worker number.
+ */
+void ThreadPool::work(int worker){
+    TraceLog::nameThread("worker " + to_string(worker));
+    unsigned long seen = 0;
+    while (true){
+        unique_lock<mutex> guard(lock);
+        wake.wait(guard, [this, &seen]{ return stopping || generation != seen; });
+        if (stopping) return;
+        seen = generation;
+        guard.unlock();
+
+        runTasks(worker);
+
+        guard.lock();
+        if (--active == 0) done.notify_all();
+    }
+}
+
+/**
+ * Claims and runs indices until none are left.
+ * @param worker The worker number.
+ */
+void ThreadPool::runTasks(int worker){
+    long long start = (TraceLog::isEnabled()) ? TraceLog::now() : 0;
+    int index;
+    int ran = 0;
+    while ((index = next.fetch_add(1)) < count){
+        (*task)(index, worker);
+        ran++;
+    }
+    if (ran > 0) TraceLog::complete("tasks", "worker", start, to_string(ran) + " tasks");
+}
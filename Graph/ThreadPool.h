@@ -0,0 +1,63 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ThreadPool.h
+//
+// Small fixed-size worker pool used to spread independent
+// pieces of graph processing over several cores. The
+// calling thread takes part in every parallel loop as
+// worker zero.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef ZELDA_THREADPOOL_H
+#define ZELDA_THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPool {
+public:
+    //Constructor/Destructor
+    explicit ThreadPool(int workers = 0);
+    ~ThreadPool();
+
+    //Getters
+    int getNumWorkers();
+    static int defaultWorkers();
+
+    //Parallel Loops
+    void parallelFor(int count, const std::function<void(int, int)>& task);
+
+private:
+    std::vector<std::thread> threads;
+    std::mutex lock;
+    std::condition_variable wake;
+    std::condition_variable done;
+
+    const std::function<void(int, int)>* task;
+    std::atomic<int> next;
+    int count;
+    int active;
+    unsigned long generation;
+    bool stopping;
+
+    void work(int worker);
+    void runTasks(int worker);
+};
+
+#endif //ZELDA_THREADPOOL_H
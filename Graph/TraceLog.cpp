@@ -0,0 +1,184 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// TraceLog.cpp
+//
+// Collects timed events from every thread and writes them
+// in the Chrome trace-event format.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include "TraceLog.h"
+#include "../JSON/json.h"
+
+using namespace std;
+
+//Every event belongs to this one process.
+static const int PROCESS_ID = 1;
+
+mutex TraceLog::lock;
+atomic<bool> TraceLog::enabled(false);
+string TraceLog::fileName;
+chrono::steady_clock::time_point TraceLog::origin;
+vector<TraceLog::Event> TraceLog::events;
+vector<string> TraceLog::external;
+atomic<int> TraceLog::nextThread(0);
+
+/**
+ * Serializes a JSON value on a single line.
+ * @param value The value.
+ * @return The compact JSON text.
+ */
+static string compact(const Json::Value& value){
+    Json::StreamWriterBuilder builder;
+    builder["indentation"] = "";
+    return Json::writeString(builder, value);
+}
+
+/**
+ * Starts recording. Times are measured from this call.
+ * @param fileName The file the trace is saved to.
+ */
+void TraceLog::begin(const string& fileName){
+    {
+        lock_guard<mutex> guard(lock);
+        TraceLog::fileName = fileName;
+        origin = chrono::steady_clock::now();
+        events.clear();
+        external.clear();
+    }
+    enabled = true;
+    nameThread("main");
+}
+
+/**
+ * Checks whether events are being recorded.
+ * @return Whether tracing is enabled.
+ */
+bool TraceLog::isEnabled(){
+    return enabled;
+}
+
+/**
+ * Gets the time since recording started.
+ * @return The time, in microseconds.
+ */
+long long TraceLog::now(){
+    return chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - origin).count();
+}
+
+/**
+ * Records an event that started earlier and ends now, on the calling thread.
+ * @param name The event name.
+ * @param category The event category.
+ * @param start When the event started, from now().
+ * @param detail Extra text shown with the event, such as a file name.
+ */
+void TraceLog::complete(const string& name, const string& category, long long start, const string& detail){
+    if (!enabled) return;
+    Event event = {name, category, detail, start, now() - start, threadID()};
+    lock_guard<mutex> guard(lock);
+    events.push_back(event);
+}
+
+/**
+ * Names the calling thread in the trace.
+ * @param name The thread name.
+ */
+void TraceLog::nameThread(const string& name){
+    if (!enabled) return;
+    Event event = {name, "", "", 0, -1, threadID()};
+    lock_guard<mutex> guard(lock);
+    events.push_back(event);
+}
+
+/**
+ * Gets a small number that identifies the calling thread in the trace.
+ * @return The thread number.
+ */
+int TraceLog::threadID(){
+    thread_local int id = nextThread++;
+    return id;
+}
+
+/**
+ * Merges the events of another trace into this one.
+ * @param trace The other trace, in the trace-event format.
+ * @param offset When the other trace started, from now().
+ * @param firstThread The number its first thread gets, so its threads stay apart from ours.
+ * @return Whether the trace could be read.
+ */
+bool TraceLog::addEvents(const string& trace, long long offset, int firstThread){
+    Json::CharReaderBuilder builder;
+    unique_ptr<Json::CharReader> reader(builder.newCharReader());
+    Json::Value root;
+    string errors;
+    if (!reader->parse(trace.data(), trace.data() + trace.size(), &root, &errors)) return false;
+
+    const Json::Value& list = (root.isObject()) ? root["traceEvents"] : root;
+    if (!list.isArray()) return false;
+
+    vector<string> merged;
+    for (Json::Value event : list){
+        if (!event.isObject()) continue;
+        if (event.isMember("ts")) event["ts"] = Json::Int64(event["ts"].asInt64() + offset);
+        event["pid"] = PROCESS_ID;
+        event["tid"] = firstThread + event.get("tid", 0).asInt();
+        merged.push_back(compact(event));
+    }
+
+    lock_guard<mutex> guard(lock);
+    external.insert(external.end(), merged.begin(), merged.end());
+    return true;
+}
+
+/**
+ * Saves every recorded and merged event.
+ * @return Boolean indicating success.
+ */
+bool TraceLog::save(){
+    lock_guard<mutex> guard(lock);
+    std::ofstream out(fileName);
+    if (!out.is_open()) return false;
+
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    for (auto& event : events){
+        Json::Value entry(Json::objectValue);
+        entry["pid"] = PROCESS_ID;
+        entry["tid"] = event.thread;
+        if (event.duration < 0){
+            entry["ph"] = "M";
+            entry["name"] = "thread_name";
+            entry["args"]["name"] = event.name;
+        } else {
+            entry["ph"] = "X";
+            entry["name"] = event.name;
+            entry["cat"] = event.category;
+            entry["ts"] = Json::Int64(event.start);
+            entry["dur"] = Json::Int64(event.duration);
+            if (!event.detail.empty()) entry["args"]["detail"] = event.detail;
+        }
+        out << ((first) ? "\n" : ",\n") << compact(entry);
+        first = false;
+    }
+    for (auto& event : external){
+        out << ((first) ? "\n" : ",\n") << event;
+        first = false;
+    }
+    out << "\n]}\n";
+    return out.good();
+}
@@ -0,0 +1,70 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// TraceLog.h
+//
+// Collects timed events from every thread and writes them
+// in the Chrome trace-event format, which chrome://tracing
+// and Perfetto load directly. Traces recorded elsewhere,
+// such as Clang's own time-trace output, can be merged in
+// so everything shares one timeline.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef ZELDA_TRACELOG_H
+#define ZELDA_TRACELOG_H
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class TraceLog {
+public:
+    //Recording
+    static void begin(const std::string& fileName);
+    static bool isEnabled();
+    static long long now();
+    static void complete(const std::string& name, const std::string& category, long long start,
+                         const std::string& detail = "");
+    static void nameThread(const std::string& name);
+    static int threadID();
+
+    //Merging
+    static bool addEvents(const std::string& trace, long long offset, int firstThread);
+
+    //Persistence
+    static bool save();
+
+private:
+    //A complete event, or thread metadata when the duration is negative.
+    struct Event {
+        std::string name;
+        std::string category;
+        std::string detail;
+        long long start;
+        long long duration;
+        int thread;
+    };
+
+    static std::mutex lock;
+    static std::atomic<bool> enabled;
+    static std::string fileName;
+    static std::chrono::steady_clock::time_point origin;
+    static std::vector<Event> events;
+    static std::vector<std::string> external;       //Merged events, already serialized.
+    static std::atomic<int> nextThread;
+};
+
+#endif //ZELDA_TRACELOG_H
@@ -0,0 +1,145 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// UnitTimes.cpp
+//
+// Records how long each translation unit took to parse
+// and traverse and how much it added to the graph.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <fstream>
+#include "UnitTimes.h"
+#include "../JSON/json.h"
+
+using namespace std;
+
+mutex UnitTimes::lock;
+LockWaits::Site UnitTimes::waits("UnitTimes");
+map<string, UnitTimes::Entry> UnitTimes::units;
+
+/**
+ * Records how long a unit took to parse. A unit walked again
+ * replaces its earlier time.
+ * @param unit The normalized name of the unit.
+ * @param seconds The parse time.
+ */
+void UnitTimes::recordParse(const string& unit, double seconds){
+    LockWaits::Guard guard(lock, waits);
+    units[unit].parse = seconds;
+}
+
+/**
+ * Records how long the walkers took to traverse a unit.
+ * @param unit The normalized name of the unit.
+ * @param seconds The traversal time.
+ */
+void UnitTimes::recordTraversal(const string& unit, double seconds){
+    LockWaits::Guard guard(lock, waits);
+    units[unit].traversal = seconds;
+}
+
+/**
+ * Records the facts a unit added to the graph.
+ * @param unit The normalized name of the unit.
+ * @param nodes The number of nodes it added.
+ * @param edges The number of edges it added.
+ */
+void UnitTimes::recordContribution(const string& unit, int nodes, int edges){
+    LockWaits::Guard guard(lock, waits);
+    Entry& entry = units[unit];
+    entry.nodes = nodes;
+    entry.edges = edges;
+}
+
+/**
+ * Gets everything recorded so far.
+ * @return The entry of every unit.
+ */
+map<string, UnitTimes::Entry> UnitTimes::getEntries(){
+    LockWaits::Guard guard(lock, waits);
+    return units;
+}
+
+/**
+ * Picks the units that took longest in total.
+ * @param entries The entries to pick from.
+ * @param count How many units to pick.
+ * @return The slowest units, slowest first.
+ */
+vector<pair<string, UnitTimes::Entry>> UnitTimes::slowest(const map<string, Entry>& entries, int count){
+    vector<pair<string, Entry>> result(entries.begin(), entries.end());
+    count = min(count, (int) result.size());
+    partial_sort(result.begin(), result.begin() + count, result.end(),
+                 [](const pair<string, Entry>& first, const pair<string, Entry>& second) -> bool {
+        return first.second.total() > second.second.total();
+    });
+    result.resize(count);
+    return result;
+}
+
+/**
+ * Saves the table as JSON.
+ * @param fileName The file to write.
+ * @return Boolean indicating success.
+ */
+bool UnitTimes::save(const string& fileName){
+    Json::Value root(Json::objectValue);
+    {
+        LockWaits::Guard guard(lock, waits);
+        for (auto& unit : units){
+            Json::Value entry(Json::objectValue);
+            entry["parseSeconds"] = unit.second.parse;
+            entry["traversalSeconds"] = unit.second.traversal;
+            entry["nodes"] = unit.second.nodes;
+            entry["edges"] = unit.second.edges;
+            root[unit.first] = entry;
+        }
+    }
+
+    std::ofstream out(fileName);
+    if (!out.is_open()) return false;
+    out << root;
+    return out.good();
+}
+
+/**
+ * Loads a table saved by an earlier run without touching this run's.
+ * @param fileName The file to read.
+ * @param entries Receives the entry of every unit.
+ * @return Boolean indicating success.
+ */
+bool UnitTimes::load(const string& fileName, map<string, Entry>& entries){
+    std::ifstream in(fileName, std::ifstream::binary);
+    if (!in.is_open()) return false;
+
+    Json::Value root;
+    try {
+        in >> root;
+    } catch (Json::Exception& e){
+        return false;
+    }
+    if (!root.isObject()) return false;
+
+    for (auto& name : root.getMemberNames()){
+        const Json::Value& value = root[name];
+        if (!value.isObject()) continue;
+        Entry& entry = entries[name];
+        entry.parse = value.get("parseSeconds", 0).asDouble();
+        entry.traversal = value.get("traversalSeconds", 0).asDouble();
+        entry.nodes = value.get("nodes", 0).asInt();
+        entry.edges = value.get("edges", 0).asInt();
+    }
+    return true;
+}
@@ -0,0 +1,65 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// UnitTimes.h
+//
+// Records how long each translation unit took to parse
+// and traverse and how much it added to the graph. The
+// table is saved alongside the other outputs of a run so
+// the next run can tell which units got slower.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef ZELDA_UNITTIMES_H
+#define ZELDA_UNITTIMES_H
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+#include "LockWaits.h"
+
+class UnitTimes {
+public:
+    struct Entry {
+        double parse = 0;               //Seconds.
+        double traversal = 0;           //Seconds.
+        int nodes = 0;
+        int edges = 0;
+
+        double total() const { return parse + traversal; }
+    };
+
+    //Recording
+    static void recordParse(const std::string& unit, double seconds);
+    static void recordTraversal(const std::string& unit, double seconds);
+    static void recordContribution(const std::string& unit, int nodes, int edges);
+
+    //Queries
+    static std::map<std::string, Entry> getEntries();
+    static std::vector<std::pair<std::string, Entry>> slowest(const std::map<std::string, Entry>& entries, int count);
+
+    //Persistence
+    static bool save(const std::string& fileName);
+    static bool load(const std::string& fileName, std::map<std::string, Entry>& entries);
+
+private:
+    static std::mutex lock;
+    static LockWaits::Site waits;
+
+    //The latest walk of each unit.
+    static std::map<std::string, Entry> units;
+};
+
+#endif //ZELDA_UNITTIMES_H
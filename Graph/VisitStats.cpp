@@ -0,0 +1,140 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// VisitStats.cpp
+//
+// Counts and times every walker callback.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "VisitStats.h"
+
+#ifdef ZELDA_VISIT_STATS
+
+#include <algorithm>
+
+using namespace std;
+
+mutex VisitStats::lock;
+vector<string> VisitStats::names;
+vector<VisitStats::Totals> VisitStats::finished;
+vector<VisitStats::ThreadTotals*> VisitStats::running;
+
+/**
+ * Registers a thread's totals so they can be read while it runs.
+ */
+VisitStats::ThreadTotals::ThreadTotals(){
+    lock_guard<mutex> guard(lock);
+    running.push_back(this);
+}
+
+/**
+ * Moves a thread's totals into the finished totals as it ends.
+ */
+VisitStats::ThreadTotals::~ThreadTotals(){
+    lock_guard<mutex> guard(lock);
+    if (finished.size() < callbacks.size()) finished.resize(callbacks.size());
+    for (int i = 0; i < callbacks.size(); i++){
+        finished[i].calls += callbacks[i].calls;
+        finished[i].time += callbacks[i].time;
+    }
+    running.erase(remove(running.begin(), running.end(), this), running.end());
+}
+
+/**
+ * Registers a callback. Each callback registers once, the first time it runs.
+ * @param name The callback name, such as ZeldaWalker::VisitCallExpr.
+ * @return The number its calls are recorded under.
+ */
+int VisitStats::addCallback(const string& name){
+    lock_guard<mutex> guard(lock);
+    names.push_back(name);
+    return (int) names.size() - 1;
+}
+
+/**
+ * Notes that the calling thread entered a callback.
+ * @param callback The callback number.
+ * @return Whether the callback was not already running on the thread.
+ */
+bool VisitStats::enter(int callback){
+    vector<int>& depths = local().depths;
+    if (callback >= depths.size()) depths.resize(callback + 1);
+    return depths[callback]++ == 0;
+}
+
+/**
+ * Notes that the calling thread left a callback.
+ * @param callback The callback number.
+ */
+void VisitStats::leave(int callback){
+    local().depths[callback]--;
+}
+
+/**
+ * Adds one call to the calling thread's totals.
+ * @param callback The callback number.
+ * @param elapsed How long the call took.
+ */
+void VisitStats::record(int callback, chrono::steady_clock::duration elapsed){
+    vector<Totals>& callbacks = local().callbacks;
+    if (callback >= callbacks.size()) callbacks.resize(callback + 1);
+    callbacks[callback].calls++;
+    callbacks[callback].time += elapsed;
+}
+
+/**
+ * Merges the totals of every thread. Meant to be read once the
+ * walks are done, as running threads update theirs without a lock.
+ * @return The calls and seconds of each callback that ran, slowest first.
+ */
+Json::Value VisitStats::toJson(){
+    lock_guard<mutex> guard(lock);
+    vector<Totals> merged = finished;
+    merged.resize(names.size());
+    for (ThreadTotals* thread : running){
+        for (int i = 0; i < thread->callbacks.size(); i++){
+            merged[i].calls += thread->callbacks[i].calls;
+            merged[i].time += thread->callbacks[i].time;
+        }
+    }
+
+    vector<int> order;
+    for (int i = 0; i < merged.size(); i++){
+        if (merged[i].calls > 0) order.push_back(i);
+    }
+    stable_sort(order.begin(), order.end(), [&merged](int first, int second) -> bool {
+        return merged[first].time > merged[second].time;
+    });
+
+    Json::Value list(Json::arrayValue);
+    for (int i : order){
+        Json::Value entry(Json::objectValue);
+        entry["name"] = names[i];
+        entry["calls"] = Json::UInt64(merged[i].calls);
+        entry["seconds"] = chrono::duration<double>(merged[i].time).count();
+        list.append(entry);
+    }
+    return list;
+}
+
+/**
+ * Gets the calling thread's totals.
+ * @return The totals.
+ */
+VisitStats::ThreadTotals& VisitStats::local(){
+    thread_local ThreadTotals totals;
+    return totals;
+}
+
+#endif //ZELDA_VISIT_STATS
@@ -0,0 +1,100 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// VisitStats.h
+//
+// Counts and times every walker callback, so the callbacks
+// that dominate a walk can be found. Each thread keeps its
+// own totals, which are merged when they are read. Nothing
+// is compiled in unless ZELDA_VISIT_STATS is defined.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef ZELDA_VISITSTATS_H
+#define ZELDA_VISITSTATS_H
+
+#ifdef ZELDA_VISIT_STATS
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "../JSON/json.h"
+
+//Counts and times the enclosing callback, including the callbacks it runs.
+//A callback entered again while it runs, as recursive ones are, counts once.
+#define ZELDA_VISIT(name) \
+    static const int zeldaVisitID = VisitStats::addCallback(name); \
+    VisitStats::Scope zeldaVisitScope(zeldaVisitID)
+
+class VisitStats {
+public:
+    //Measures one call, from construction until destruction. Only the
+    //outermost call of a callback on a thread is timed.
+    class Scope {
+    public:
+        explicit Scope(int callback) : callback(callback), outermost(VisitStats::enter(callback)) {
+            if (outermost) start = std::chrono::steady_clock::now();
+        }
+        ~Scope() {
+            VisitStats::leave(callback);
+            if (outermost) VisitStats::record(callback, std::chrono::steady_clock::now() - start);
+        }
+
+    private:
+        int callback;
+        bool outermost;
+        std::chrono::steady_clock::time_point start;
+    };
+
+    //Registration
+    static int addCallback(const std::string& name);
+
+    //Recording
+    static bool enter(int callback);
+    static void leave(int callback);
+    static void record(int callback, std::chrono::steady_clock::duration elapsed);
+
+    //Output
+    static Json::Value toJson();
+
+private:
+    struct Totals {
+        unsigned long long calls = 0;
+        std::chrono::steady_clock::duration time = std::chrono::steady_clock::duration::zero();
+    };
+
+    //The totals of one thread, merged into the finished totals when the thread ends.
+    struct ThreadTotals {
+        std::vector<Totals> callbacks;
+        std::vector<int> depths;        //Calls of each callback running on the thread.
+
+        ThreadTotals();
+        ~ThreadTotals();
+    };
+
+    static std::mutex lock;
+    static std::vector<std::string> names;
+    static std::vector<Totals> finished;
+    static std::vector<ThreadTotals*> running;
+
+    static ThreadTotals& local();
+};
+
+#else
+
+#define ZELDA_VISIT(name)
+
+#endif //ZELDA_VISIT_STATS
+
+#endif //ZELDA_VISITSTATS_H
@@ -33,6 +33,7 @@
 #include <cstring>
 #include "ZeldaEdge.h"
 #include "ZeldaNode.h"
+#include "MemoryReport.h"
 
 using namespace std;
 
@@ -229,6 +230,23 @@ void ZeldaEdge::setType(ZeldaEdge::EdgeType type){
     this->type = type;
 }
 
+/**
+ * Sets the file the edge was recorded from. Must be set before
+ * the edge is added to a graph.
+ * @param fileID The interned file ID.
+ */
+void ZeldaEdge::setFileID(int fileID){
+    this->fileID = fileID;
+}
+
+/**
+ * Sets the translation unit the edge was recorded in.
+ * @param unitID The interned file ID of the unit.
+ */
+void ZeldaEdge::setUnitID(int unitID){
+    this->unitID = unitID;
+}
+
 /**
  * Gets the source node.
  * @return The node of the source.
@@ -305,6 +323,22 @@ int ZeldaEdge::getNumAttributes(){
 return (int) (singleAttributes.size() + multiAttributes.size());
 }
 
+/**
+ * Gets the file the edge was recorded from.
+ * @return The interned file ID, or -1 if unknown.
+ */
+int ZeldaEdge::getFileID(){
+    return fileID;
+}
+
+/**
+ * Gets the translation unit the edge was recorded in.
+ * @return The interned file ID of the unit, or -1 if unknown.
+ */
+int ZeldaEdge::getUnitID(){
+    return unitID;
+}
+
 /**
  * Adds an attribute that only has one value.
  * @param key The key of the attribute.
@@ -383,3 +417,15 @@ string ZeldaEdge::generateTAAttribute(){
 
     return attributes;
 }
+
+/**
+ * Adds the memory this edge holds to a report.
+ * @param report The report to add to.
+ */
+void ZeldaEdge::addMemory(MemoryReport& report){
+    report.addEdge(typeToString(type), sizeof(ZeldaEdge));
+    report.addStrings(MemoryReport::heapBytes(sourceID) + MemoryReport::heapBytes(destID) +
+                      MemoryReport::heapBytes(sourceName) + MemoryReport::heapBytes(destName));
+    report.addAttributes(singleAttributes);
+    report.addAttributes(multiAttributes);
+}
@@ -30,6 +30,7 @@
 #define REX_REXEDGE_H
 
 class ZeldaNode;
+class MemoryReport;
 #include <string>
 #include <map>
 #include <set>
@@ -59,6 +60,8 @@ public:
     void setSourceName(std::string name);
     void setDestName(std::string name);
     void setType(EdgeType type);
+    void setFileID(int fileID);
+    void setUnitID(int unitID);
 
     //Getters
     ZeldaNode* getSource();
@@ -69,6 +72,8 @@ public:
     std::string getSourceName();
     std::string getDestinationName();
     int getNumAttributes();
+    int getFileID();
+    int getUnitID();
 
     //Attribute Manager
     void addSingleAttribute(std::string key, std::string value);
@@ -80,6 +85,9 @@ public:
     std::string generateTAEdge();
     std::string generateTAAttribute();
 
+    //Memory Accounting
+    void addMemory(MemoryReport& report);
+
 private:
     ZeldaNode* sourceNode;
     ZeldaNode* destNode;
@@ -91,6 +99,10 @@ private:
 
     EdgeType type;
 
+    //Interned file and translation unit the edge was recorded from.
+    int fileID = -1;
+    int unitID = -1;
+
     //std::string getMD5(std::string ID);
 
     std::map<std::string, std::string> singleAttributes;
@@ -31,6 +31,7 @@
 #include <algorithm>
 #include <sstream>
 #include "ZeldaNode.h"
+#include "MemoryReport.h"
 
 using namespace std;
 
@@ -74,6 +75,9 @@ string ZeldaNode::typeToString(ZeldaNode::NodeType type){
  */
 ZeldaNode::ZeldaNode(std::string ID, NodeType type){
     this->ID = ID;
+    this->scope = nullptr;
+    this->owner = nullptr;
+    this->resolved = false;
     this->name = ID;
     this->type = type;
 }
@@ -88,6 +92,9 @@ ZeldaNode::ZeldaNode(std::string ID, std::string name, NodeType type){
     this->ID = ID;
     this->name = name;
     this->type = type;
+    this->scope = nullptr;
+    this->owner = nullptr;
+    this->resolved = false;
 
     //Add the label.
     addSingleAttribute(LABEL_FLAG, name);
@@ -164,6 +171,56 @@ int ZeldaNode::getNumAttributes(){
     return (int) (singleAttributes.size() + multiAttributes.size() + countAttributes.size());
 }
 
+/**
+ * Gets the enclosing scope. This is the function, try or catch
+ * containing a try or throw, or the try owning a catch.
+ * @return The scope node, or null if unknown.
+ */
+ZeldaNode* ZeldaNode::getScope(){
+    return scope;
+}
+
+/**
+ * Gets the try that owns a catch.
+ * @return The try node, or null.
+ */
+ZeldaNode* ZeldaNode::getOwner(){
+    return owner;
+}
+
+/**
+ * Gets the catches of a try in source order.
+ * @return The handler nodes.
+ */
+const vector<ZeldaNode*>& ZeldaNode::getHandlers(){
+    return handlers;
+}
+
+/**
+ * Checks whether a throw was already propagated while its
+ * translation unit was processed.
+ * @return Whether the throw is resolved.
+ */
+bool ZeldaNode::isResolved(){
+    return resolved;
+}
+
+/**
+ * Gets the file the node was recorded from.
+ * @return The interned file ID, or -1 if unknown.
+ */
+int ZeldaNode::getFileID(){
+    return fileID;
+}
+
+/**
+ * Gets the translation unit the node was recorded in.
+ * @return The interned file ID of the unit, or -1 if unknown.
+ */
+int ZeldaNode::getUnitID(){
+    return unitID;
+}
+
 /**
  * Sets the ID.
  * @param newID The new ID to add.
@@ -191,6 +248,64 @@ void ZeldaNode::setType(NodeType newType){
     type = newType;
 }
 
+/**
+ * Sets the enclosing scope.
+ * @param newScope The scope node.
+ */
+void ZeldaNode::setScope(ZeldaNode* newScope){
+    scope = newScope;
+}
+
+/**
+ * Sets the try that owns a catch.
+ * @param newOwner The try node.
+ */
+void ZeldaNode::setOwner(ZeldaNode* newOwner){
+    owner = newOwner;
+}
+
+/**
+ * Marks a throw as propagated.
+ * @param newResolved Whether the throw is resolved.
+ */
+void ZeldaNode::setResolved(bool newResolved){
+    resolved = newResolved;
+}
+
+/**
+ * Sets the file the node was recorded from. Must be set before
+ * the node is added to a graph.
+ * @param newFileID The interned file ID.
+ */
+void ZeldaNode::setFileID(int newFileID){
+    fileID = newFileID;
+}
+
+/**
+ * Sets the translation unit the node was recorded in.
+ * @param newUnitID The interned file ID of the unit.
+ */
+void ZeldaNode::setUnitID(int newUnitID){
+    unitID = newUnitID;
+}
+
+/**
+ * Appends a catch to a try. Headers seen by several translation
+ * units visit the same try again, so known handlers are skipped.
+ * @param handler The catch node.
+ */
+void ZeldaNode::addHandler(ZeldaNode* handler){
+    if (find(handlers.begin(), handlers.end(), handler) != handlers.end()) return;
+    handlers.push_back(handler);
+}
+
+/**
+ * Removes every catch from a try.
+ */
+void ZeldaNode::clearHandlers(){
+    handlers.clear();
+}
+
 /**
  * Adds a single attribute.
  * @param key The key.
@@ -219,17 +334,24 @@ void ZeldaNode::addBoolAttribute(const std::string& key, bool value, bool cumula
   }
 }
 
+/**
+ * Removes an attribute of any kind.
+ * @param key The key.
+ */
+void ZeldaNode::removeAttribute(const std::string& key){
+    singleAttributes.erase(key);
+    boolAttributes.erase(key);
+    countAttributes.erase(key);
+    multiAttributes.erase(key);
+}
+
 /**
  * Adds a multi attribute.
  * @param key The key.
  * @param value The value.
  */
 void ZeldaNode::addMultiAttribute(const std::string& key, std::string value){
-    //Get the vector for the key.
-    set<string> kV = multiAttributes[key];
-    if (std::find(kV.begin(), kV.end(), value) != kV.end()) return;
-
-    //Add the pair to the list.
+    //Add the pair to the list. The set ignores duplicates.
     multiAttributes[key].emplace(value);
 }
 
@@ -282,3 +404,17 @@ string ZeldaNode::generateTAAttribute(){
 
     return attributes;
 }
+
+/**
+ * Adds the memory this node holds to a report.
+ * @param report The report to add to.
+ */
+void ZeldaNode::addMemory(MemoryReport& report){
+    report.addNode(typeToString(type), sizeof(ZeldaNode) + handlers.capacity() * sizeof(ZeldaNode*));
+    report.addStrings(MemoryReport::heapBytes(ID) + MemoryReport::heapBytes(name) +
+                      MemoryReport::heapBytes(INSTANCE_FLAG) + MemoryReport::heapBytes(LABEL_FLAG));
+    report.addAttributes(singleAttributes);
+    report.addAttributes(boolAttributes);
+    report.addAttributes(countAttributes);
+    report.addAttributes(multiAttributes);
+}
@@ -32,6 +32,9 @@
 #include <map>
 #include <set>
 #include <string>
+#include <vector>
+
+class MemoryReport;
 
 class ZeldaNode {
 public:
@@ -53,27 +56,56 @@ public:
     std::string getSingleAttribute(std::string key);
     std::set<std::string> getMultiAttribute(std::string key);
     int getNumAttributes();
+    ZeldaNode* getScope();
+    ZeldaNode* getOwner();
+    const std::vector<ZeldaNode*>& getHandlers();
+    bool isResolved();
+    int getFileID();
+    int getUnitID();
 
     //Setters
     void setID(std::string newID);
     void setName(std::string newName);
     void setType(NodeType newType);
+    void setScope(ZeldaNode* newScope);
+    void setOwner(ZeldaNode* newOwner);
+    void setResolved(bool newResolved);
+    void setFileID(int newFileID);
+    void setUnitID(int newUnitID);
+
+    //Structure Managers
+    void addHandler(ZeldaNode* handler);
+    void clearHandlers();
 
     //Attribute Managers
     void addSingleAttribute(const std::string& key, std::string value);
     void addCountAttribute(const std::string& key, int value = 0);
     void addMultiAttribute(const std::string& key, std::string value);
     void addBoolAttribute(const std::string& key, bool value, bool cumulative = false, bool isAnd = true);
+    void removeAttribute(const std::string& key);
 
     //TA Generators
     std::string generateTANode();
     std::string generateTAAttribute();
 
+    //Memory Accounting
+    void addMemory(MemoryReport& report);
+
 private:
     std::string ID;
     std::string name;
     NodeType type;
 
+    //Direct links for try, catch and throw nodes.
+    ZeldaNode* scope;
+    ZeldaNode* owner;
+    std::vector<ZeldaNode*> handlers;
+    bool resolved;
+
+    //Interned file and translation unit the node was recorded from.
+    int fileID = -1;
+    int unitID = -1;
+
     std::map<std::string, std::string> singleAttributes;
     std::map<std::string, bool> boolAttributes;
     std::map<std::string, int> countAttributes;
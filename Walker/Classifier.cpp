@@ -85,6 +85,7 @@ void Classifier::updateType(std::string& s){
 
 
 bool Classifier::VisitFunctionDecl(FunctionDecl* func){
+  ZELDA_VISIT("Classifier::VisitFunctionDecl");
   if ( ! isInSystemHeader(func) ) {
     currFunction = func;
     if ( func->isThisDeclarationADefinition() ){
@@ -103,6 +104,7 @@ bool Classifier::VisitFunctionDecl(FunctionDecl* func){
 }
 
 bool Classifier::TraverseCXXCatchStmt(CXXCatchStmt* stmt){
+    ZELDA_VISIT("Classifier::TraverseCXXCatchStmt");
 
   if ( currFunction ){
     string catchType = stmt->getCaughtType().getAsString();
@@ -141,6 +143,7 @@ bool Classifier::TraverseCXXCatchStmt(CXXCatchStmt* stmt){
 }
 
 bool Classifier::TraverseCXXTryStmt(CXXTryStmt* stmt){
+  ZELDA_VISIT("Classifier::TraverseCXXTryStmt");
   if ( currFunction ){
     tries.emplace_back();
     bool hasChildren = false;
@@ -172,6 +175,7 @@ bool Classifier::TraverseCXXTryStmt(CXXTryStmt* stmt){
 }
 
 bool Classifier::VisitCXXThrowExpr(CXXThrowExpr* expr){
+  ZELDA_VISIT("Classifier::VisitCXXThrowExpr");
   ostream* out = getStream();
   if ( out ){
     string throwType;
@@ -189,6 +193,7 @@ bool Classifier::VisitCXXThrowExpr(CXXThrowExpr* expr){
 }
 
 bool Classifier::VisitReturnStmt(ReturnStmt*){
+  ZELDA_VISIT("Classifier::VisitReturnStmt");
   ostream* out = getStream();
   if ( out ){
     *out << "return;";
@@ -197,6 +202,7 @@ bool Classifier::VisitReturnStmt(ReturnStmt*){
 }
 
 bool Classifier::VisitContinueStmt(ContinueStmt*){
+  ZELDA_VISIT("Classifier::VisitContinueStmt");
   ostream* out = getStream();
   if ( out ){
     *out << "continue;";
@@ -205,6 +211,7 @@ bool Classifier::VisitContinueStmt(ContinueStmt*){
 }
 
 bool Classifier::VisitBreakStmt(BreakStmt*){
+  ZELDA_VISIT("Classifier::VisitBreakStmt");
   ostream* out = getStream();
   if ( out ){
     *out << "break;";
@@ -213,6 +220,7 @@ bool Classifier::VisitBreakStmt(BreakStmt*){
 }
 
 bool Classifier::VisitCXXDeleteExpr(CXXDeleteExpr* expr){
+  ZELDA_VISIT("Classifier::VisitCXXDeleteExpr");
   ostream* out = getStream();
   if ( out ){
     *out << "delete" << ( expr->isArrayForm() ? "[] " : " " ) << expr->getDestroyedType().getAsString() << ";";
@@ -255,6 +263,7 @@ void Classifier::functionInfo(FunctionDecl* func){
 }
 
 bool Classifier::VisitCXXMemberCallExpr(CXXMemberCallExpr* member){
+  ZELDA_VISIT("Classifier::VisitCXXMemberCallExpr");
   ostream* out = getStream();
   if ( out ){
     string called;
@@ -270,6 +279,7 @@ bool Classifier::VisitCXXMemberCallExpr(CXXMemberCallExpr* member){
 }
 
 bool Classifier::VisitCallExpr(CallExpr* call){
+  ZELDA_VISIT("Classifier::VisitCallExpr");
   ostream* out = getStream();
   if ( out ){
     string called;
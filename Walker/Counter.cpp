@@ -29,15 +29,19 @@
 #include <boost/filesystem.hpp>
 #include <boost/algorithm/string/predicate.hpp>
 #include "../Graph/ZeldaNode.h"
+#include "../Graph/FileTable.h"
 #include "clang/AST/DeclCXX.h"
 #include <fstream>
 #include <sstream>
 
 using namespace std;
 
+mutex Counter::lock;
+LockWaits::Site Counter::waits("Counter");
 CountTypes Counter::tries;
 CountTypes Counter::catches;
 CountTypes Counter::nonExceptional;
+map<int, vector<CountTypes>> Counter::unitCounts;
 
 CountTypes::CountTypes(){
   occurs["try"];
@@ -56,6 +60,12 @@ CountTypes::CountTypes(){
 
 int& CountTypes::get(const std::string& s) { return occurs[s]; }
 
+void CountTypes::add(const CountTypes& other, int sign){
+  for ( auto elem : other.occurs ){
+    occurs[elem.first] += sign * elem.second;
+  }
+}
+
 const map<string,int> CountTypes::getMap() const { return occurs; }
 /**
  * Constructor
@@ -67,10 +77,35 @@ Counter::Counter(ASTContext *Context) : ParentWalker(Context) {}
  * Destructor
  */
 
+/**
+ * Counts a translation unit, then adds what it found to the totals,
+ * remembering it so it can be taken back out.
+ * @param decl The translation unit.
+ * @return Whether the traversal completed.
+ */
+bool Counter::TraverseTranslationUnitDecl(TranslationUnitDecl* decl){
+  ZELDA_VISIT("Counter::TraverseTranslationUnitDecl");
+  int unit = FileTable::intern(generateUnitName());
+  bool result = RecursiveASTVisitor<Counter>::TraverseTranslationUnitDecl(decl);
+
+  LockWaits::Guard guard(lock, waits);
+  tries.add(unitTries);
+  catches.add(unitCatches);
+  nonExceptional.add(unitNonExceptional);
+
+  vector<CountTypes>& counts = unitCounts[unit];
+  counts.resize(3);
+  counts[0].add(unitTries);
+  counts[1].add(unitCatches);
+  counts[2].add(unitNonExceptional);
+  return result;
+}
+
 bool Counter::TraverseFunctionDecl(FunctionDecl* func){
+  ZELDA_VISIT("Counter::TraverseFunctionDecl");
   if ( ! isInSystemHeader(func) ) {
     if ( func->isThisDeclarationADefinition() ){
-      current.emplace_back(&nonExceptional);
+      current.emplace_back(&unitNonExceptional);
       TraverseStmt(func->getBody());
       current.pop_back();
     }
@@ -79,8 +114,9 @@ bool Counter::TraverseFunctionDecl(FunctionDecl* func){
 }
 
 bool Counter::TraverseCXXTryStmt(CXXTryStmt* stmt){
+  ZELDA_VISIT("Counter::TraverseCXXTryStmt");
   if ( ! isInSystemHeader(stmt) ){
-    current.emplace_back(&tries);
+    current.emplace_back(&unitTries);
     VisitCXXTryStmt(stmt);
     for( auto child: stmt->children() ) { TraverseStmt(child); } 
     current.pop_back();
@@ -89,8 +125,9 @@ bool Counter::TraverseCXXTryStmt(CXXTryStmt* stmt){
 }
 
 bool Counter::TraverseCXXCatchStmt(CXXCatchStmt* stmt){
+  ZELDA_VISIT("Counter::TraverseCXXCatchStmt");
   if ( ! isInSystemHeader(stmt) ){
-    current.emplace_back(&catches);
+    current.emplace_back(&unitCatches);
     VisitCXXCatchStmt(stmt);
     for( auto child: stmt->children() ) { TraverseStmt(child); } 
     current.pop_back();
@@ -99,53 +136,65 @@ bool Counter::TraverseCXXCatchStmt(CXXCatchStmt* stmt){
 }
 
 bool Counter::VisitCXXTryStmt(CXXTryStmt*){
+  ZELDA_VISIT("Counter::VisitCXXTryStmt");
   return addCount("try");
 }
 
 bool Counter::VisitCXXCatchStmt(CXXCatchStmt*){
+  ZELDA_VISIT("Counter::VisitCXXCatchStmt");
   return addCount("catch");
 }
 
 
 
 bool Counter::VisitCXXThrowExpr(CXXThrowExpr*){
+  ZELDA_VISIT("Counter::VisitCXXThrowExpr");
   return addCount("throw");
 }
 
 
 bool Counter::VisitSwitchCase(SwitchCase*){
+  ZELDA_VISIT("Counter::VisitSwitchCase");
   return addCount("switch");
 }
 
 bool Counter::VisitIfStmt(IfStmt*){
+  ZELDA_VISIT("Counter::VisitIfStmt");
   return addCount("if");
 }
 
 bool Counter::VisitWhileStmt(WhileStmt*){
+  ZELDA_VISIT("Counter::VisitWhileStmt");
   return addCount("while");
 }
 
 bool Counter::VisitDoStmt(DoStmt*){
+  ZELDA_VISIT("Counter::VisitDoStmt");
   return addCount("do");
 }
 
 bool Counter::VisitForStmt(ForStmt*){
+  ZELDA_VISIT("Counter::VisitForStmt");
   return addCount("for");
 }
 
 bool Counter::VisitReturnStmt(ReturnStmt*){
+  ZELDA_VISIT("Counter::VisitReturnStmt");
   return addCount("return");
 }
 
 bool Counter::VisitContinueStmt(ContinueStmt*){
+  ZELDA_VISIT("Counter::VisitContinueStmt");
   return addCount("continue");
 }
 
 bool Counter::VisitBreakStmt(BreakStmt*){
+  ZELDA_VISIT("Counter::VisitBreakStmt");
   return addCount("break");
 }
 
 bool Counter::VisitCXXDeleteExpr(CXXDeleteExpr*){
+  ZELDA_VISIT("Counter::VisitCXXDeleteExpr");
   return addCount("delete");
 }
 
@@ -158,6 +207,7 @@ bool Counter::addCount(const std::string& s){
 }
 
 void Counter::printData(int exceptions, std::ostream& out ){
+  LockWaits::Guard guard(lock, waits);
 
   CountTypes* toPrint = nullptr;
   if ( exceptions == 0 ) toPrint = &tries;
@@ -168,6 +218,22 @@ void Counter::printData(int exceptions, std::ostream& out ){
   out << *toPrint; 
 }
 
+/**
+ * Takes the counts of a translation unit back out of the totals
+ * before the unit is walked again.
+ * @param unitID The interned file ID of the unit.
+ */
+void Counter::retractUnit(int unitID){
+  LockWaits::Guard guard(lock, waits);
+  auto it = unitCounts.find(unitID);
+  if ( it == unitCounts.end() ) return;
+
+  tries.add(it->second[0], -1);
+  catches.add(it->second[1], -1);
+  nonExceptional.add(it->second[2], -1);
+  unitCounts.erase(it);
+}
+
 std::ostream& operator<<(std::ostream& out, const CountTypes& ct){
   for ( auto elem : ct.getMap()  ){
     out << elem.first <<"," << elem.second << endl; 
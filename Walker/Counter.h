@@ -32,9 +32,11 @@
 #include "clang/Tooling/CommonOptionsParser.h"
 #include "llvm/Support/CommandLine.h"
 #include "../Graph/TAGraph.h"
+#include "../Graph/LockWaits.h"
 #include "ParentWalker.h"
 #include <vector>
 #include <map>
+#include <mutex>
 #include <iostream>
 
 using namespace llvm;
@@ -46,6 +48,7 @@ class CountTypes{
   std::map<std::string, int> occurs;
  public:
   int& get(const std::string&);
+  void add(const CountTypes&, int sign = 1);
   CountTypes();
   const std::map<std::string,int> getMap() const;
 
@@ -61,6 +64,7 @@ public:
     //Constructor/Destructor
     explicit Counter(ASTContext *Context);
  
+    bool TraverseTranslationUnitDecl(TranslationUnitDecl*);
     bool TraverseFunctionDecl(FunctionDecl*);
     bool TraverseCXXTryStmt(CXXTryStmt*);
     bool TraverseCXXCatchStmt(CXXCatchStmt* stmt);
@@ -81,15 +85,26 @@ public:
     bool VisitCXXDeleteExpr(CXXDeleteExpr*);
 
     static void printData(int, std::ostream& out = std::cout );
+    static void retractUnit(int unitID);
 
 private:
 
     bool addCount(const std::string& s);
 
+    static std::mutex lock;
+    static LockWaits::Site waits;
     static CountTypes tries;
     static CountTypes catches;
     static CountTypes nonExceptional;
 
+    // what each translation unit added to the totals, so it can be taken back out
+    static std::map<int, std::vector<CountTypes>> unitCounts;
+
+    // this unit's counts, kept apart so units can be counted on several threads
+    CountTypes unitTries;
+    CountTypes unitCatches;
+    CountTypes unitNonExceptional;
+
     std::vector<CountTypes*> current;
 };
 
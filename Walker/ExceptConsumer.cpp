@@ -25,6 +25,8 @@
 /////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 #include "ExceptConsumer.h"
+#include "IncludeRecorder.h"
+#include "clang/Lex/Preprocessor.h"
 
 using namespace std;
 
@@ -34,19 +36,32 @@ string ExceptConsumer::classifyFile = "";
 /**
  * Creates a Zelda consumer.
  * @param Context The AST context.
+ * @param parseTimer The timer to stop once the AST is parsed, if any.
+ * @param unit The normalized name of the file, used to record its times.
  */
-ExceptConsumer::ExceptConsumer(ASTContext *Context) : exception{Context}, counter{Context}, classify{Context}, walker{Context} {}
+ExceptConsumer::ExceptConsumer(ASTContext *Context, PhaseStats::Timer* parseTimer, string unit) :
+        exception{Context}, counter{Context}, classify{Context}, walker{Context}, parseTimer(parseTimer),
+        unit(unit) {}
 
 /**
  * Handles the AST context's translation unit. Tells Clang to traverse AST.
  * @param Context The AST context.
  */
 void ExceptConsumer::HandleTranslationUnit(ASTContext &Context) {
+        if (parseTimer){
+            double parse = parseTimer->stop();
+            if (!unit.empty()) UnitTimes::recordParse(unit, parse);
+        }
+
+        //The graph walkers are off, so throws are not resolved per unit either.
 //        walker.addLibrariesToIgnore(ExceptConsumer::libraries);
 //        walker.TraverseDecl(Context.getTranslationUnitDecl());
         
+        PhaseStats::Timer timer("counter traversal");
         counter.addLibrariesToIgnore(ExceptConsumer::libraries);
         counter.TraverseDecl(Context.getTranslationUnitDecl());
+        double traversal = timer.stop();
+        if (!unit.empty()) UnitTimes::recordTraversal(unit, traversal);
 
 //        exception.addLibrariesToIgnore(ExceptConsumer::libraries);
 //        exception.TraverseDecl(Context.getTranslationUnitDecl());
@@ -74,5 +89,29 @@ void ExceptConsumer::setLibrariesToIgnore(vector<string> libraries){
  * @return A pointer to the AST consumer.
  */
 std::unique_ptr<ASTConsumer> ZeldaAction::CreateASTConsumer(CompilerInstance &Compiler, StringRef InFile) {
-    return std::unique_ptr<ASTConsumer>(new ExceptConsumer(&Compiler.getASTContext()));
+    return std::unique_ptr<ASTConsumer>(new ExceptConsumer(&Compiler.getASTContext(), parseTimer.get(), unit));
+}
+
+/**
+ * Hooks the include recorder into the preprocessor and starts timing
+ * the file before it is parsed.
+ * @param Compiler The compiler instance to process.
+ * @return Whether the action may proceed.
+ */
+bool ZeldaAction::BeginSourceFileAction(CompilerInstance &Compiler) {
+    unit = ParentWalker::normalizeFileName(getCurrentFile().str());
+    unitTimer.reset(new PhaseStats::Timer("unit", unit));
+    parseTimer.reset(new PhaseStats::Timer("parse", unit));
+    Compiler.getPreprocessor().addPPCallbacks(
+            std::unique_ptr<PPCallbacks>(new IncludeRecorder(Compiler.getSourceManager(), unit)));
+    return ASTFrontendAction::BeginSourceFileAction(Compiler);
+}
+
+/**
+ * Finishes timing the file once Clang is done with it.
+ */
+void ZeldaAction::EndSourceFileAction() {
+    parseTimer.reset();
+    unitTimer.reset();
+    ASTFrontendAction::EndSourceFileAction();
 }
@@ -27,18 +27,21 @@
 #ifndef EXCEPT_CONSUMER_H
 #define EXCEPT_CONSUMER_H
 
+#include <memory>
 #include <string>
 #include <vector>
 #include "ExceptWalker.h"
 #include "Classifier.h"
 #include "ZeldaWalker.h"
 #include "Counter.h"
+#include "../Graph/PhaseStats.h"
+#include "../Graph/UnitTimes.h"
 
 
 class ExceptConsumer : public ASTConsumer {
 public:
     //Constructor/Destructor
-    explicit ExceptConsumer(ASTContext *Context);
+    explicit ExceptConsumer(ASTContext *Context, PhaseStats::Timer* parseTimer = nullptr, std::string unit = "");
     virtual void HandleTranslationUnit(ASTContext &Context);
 
     //Mode Functions
@@ -56,6 +59,8 @@ private:
     Classifier classify;
     ZeldaWalker walker;
     Counter counter;
+    PhaseStats::Timer* parseTimer;
+    std::string unit;
 
     static std::vector<std::string> libraries;
 };
@@ -64,6 +69,18 @@ class ZeldaAction : public ASTFrontendAction {
 public:
     //Consumer Functions
     virtual std::unique_ptr<ASTConsumer> CreateASTConsumer(CompilerInstance &Compiler, StringRef InFile);
+    virtual bool BeginSourceFileAction(CompilerInstance &Compiler);
+    virtual void EndSourceFileAction();
+
+private:
+    //The normalized name of the file being walked.
+    std::string unit;
+
+    //Runs from the start of the file until it is done.
+    std::unique_ptr<PhaseStats::Timer> unitTimer;
+
+    //Runs from the start of the file until its AST is handed over.
+    std::unique_ptr<PhaseStats::Timer> parseTimer;
 };
 
 #endif
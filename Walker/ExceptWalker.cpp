@@ -51,6 +51,7 @@ std::string ExceptWalker::QualTypeString(const QualType& qt){
 }
 
 bool ExceptWalker::VisitFunctionDecl(FunctionDecl* decl){
+  ZELDA_VISIT("ExceptWalker::VisitFunctionDecl");
   if ( decl->isThisDeclarationADefinition() &&  decl->hasBody() ){
     currFunction = decl;
     functionName = getCurrFunctionName();
@@ -59,6 +60,7 @@ bool ExceptWalker::VisitFunctionDecl(FunctionDecl* decl){
 }
 
 bool ExceptWalker::VisitCXXMethodDecl(CXXMethodDecl* decl){
+  ZELDA_VISIT("ExceptWalker::VisitCXXMethodDecl");
   if ( decl->isThisDeclarationADefinition() &&  decl->hasBody() ){
     currFunction = decl;
     string thisType;
@@ -91,6 +93,7 @@ string ExceptWalker::getCurrFunctionName(){
  * @return Whether we should continue.
  */
 bool ExceptWalker::VisitCXXThrowExpr(CXXThrowExpr* expr) {
+  ZELDA_VISIT("ExceptWalker::VisitCXXThrowExpr");
   Stmt* sub = expr->getSubExpr();
   throwOut << functionName << ";throw expr; ";
   string type;
@@ -106,6 +109,7 @@ bool ExceptWalker::VisitCXXThrowExpr(CXXThrowExpr* expr) {
 }
 
 bool ExceptWalker::VisitCXXCatchStmt(CXXCatchStmt* stmt){
+  ZELDA_VISIT("ExceptWalker::VisitCXXCatchStmt");
   catchOut << functionName << ";catchStmt;";
   string type;
   if ( stmt->getExceptionDecl() ){
@@ -119,6 +123,7 @@ bool ExceptWalker::VisitCXXCatchStmt(CXXCatchStmt* stmt){
 }
 
 bool ExceptWalker::VisitCXXTryStmt(CXXTryStmt* stmt){
+  ZELDA_VISIT("ExceptWalker::VisitCXXTryStmt");
   tryOut << functionName << ";try statement;" << stmt->getNumHandlers() << endl; 
   
   return true;
@@ -0,0 +1,78 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// IncludeRecorder.cpp
+//
+// Preprocessor callbacks that record the include directives
+// of a translation unit into the include graph.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "IncludeRecorder.h"
+#include "ParentWalker.h"
+#include "../Graph/IncludeGraph.h"
+
+using namespace std;
+
+/**
+ * Starts recording a unit.
+ * @param manager The source manager of the unit.
+ * @param unit The normalized name of the unit.
+ */
+IncludeRecorder::IncludeRecorder(SourceManager& manager, string unit) : manager(manager), unit(unit) {
+    IncludeGraph::beginUnit(unit);
+}
+
+#if CLANG_VER_LTE
+void IncludeRecorder::InclusionDirective(SourceLocation hashLoc, const Token& includeTok, StringRef fileName,
+                                         bool isAngled, CharSourceRange fileNameRange, const FileEntry* file,
+                                         StringRef searchPath, StringRef relativePath, const Module* imported){
+    recordInclude(hashLoc, file);
+}
+#else
+void IncludeRecorder::InclusionDirective(SourceLocation hashLoc, const Token& includeTok, StringRef fileName,
+                                         bool isAngled, CharSourceRange fileNameRange, const FileEntry* file,
+                                         StringRef searchPath, StringRef relativePath, const Module* imported,
+                                         SrcMgr::CharacteristicKind fileType){
+    //System headers do not change with the code under analysis.
+    if (SrcMgr::isSystem(fileType)) return;
+    recordInclude(hashLoc, file);
+}
+#endif
+
+/**
+ * Records one include directive.
+ * @param hashLoc The location of the directive.
+ * @param file The file that was included, or null if it was not found.
+ */
+void IncludeRecorder::recordInclude(SourceLocation hashLoc, const FileEntry* file){
+    if (!file || hashLoc.isInvalid() || manager.isInSystemHeader(hashLoc)) return;
+
+    string includer = manager.getFilename(hashLoc).str();
+    string included(file->getName());
+    if (includer.empty() || included.empty()) return;
+
+    IncludeGraph::addInclude(unit, normalize(includer), normalize(included));
+}
+
+/**
+ * Normalizes a filename, remembering the result since the same
+ * headers are included over and over.
+ * @param fileName The filename as the preprocessor reports it.
+ * @return The normalized filename.
+ */
+const string& IncludeRecorder::normalize(const string& fileName){
+    auto it = names.find(fileName);
+    if (it != names.end()) return it->second;
+    return names[fileName] = ParentWalker::normalizeFileName(fileName);
+}
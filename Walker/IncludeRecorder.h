@@ -0,0 +1,57 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// IncludeRecorder.h
+//
+// Preprocessor callbacks that record the include directives
+// of a translation unit into the include graph.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef ZELDA_INCLUDERECORDER_H
+#define ZELDA_INCLUDERECORDER_H
+
+#include <map>
+#include <string>
+#include "clang/Basic/SourceManager.h"
+#include "clang/Lex/PPCallbacks.h"
+
+using namespace clang;
+
+class IncludeRecorder : public PPCallbacks {
+public:
+    //Constructor
+    IncludeRecorder(SourceManager& manager, std::string unit);
+
+    //Preprocessor Callbacks
+#if CLANG_VER_LTE
+    void InclusionDirective(SourceLocation hashLoc, const Token& includeTok, StringRef fileName, bool isAngled,
+                            CharSourceRange fileNameRange, const FileEntry* file, StringRef searchPath,
+                            StringRef relativePath, const Module* imported) override;
+#else
+    void InclusionDirective(SourceLocation hashLoc, const Token& includeTok, StringRef fileName, bool isAngled,
+                            CharSourceRange fileNameRange, const FileEntry* file, StringRef searchPath,
+                            StringRef relativePath, const Module* imported,
+                            SrcMgr::CharacteristicKind fileType) override;
+#endif
+
+private:
+    SourceManager& manager;
+    std::string unit;
+    std::map<std::string, std::string> names;
+
+    void recordInclude(SourceLocation hashLoc, const FileEntry* file);
+    const std::string& normalize(const std::string& fileName);
+};
+
+#endif //ZELDA_INCLUDERECORDER_H
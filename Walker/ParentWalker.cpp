@@ -34,19 +34,27 @@
 #include <boost/algorithm/string/replace.hpp>
 #include <sstream>
 #include "ParentWalker.h"
+#include "../Graph/ExceptionFlow.h"
+#include "../Graph/FileTable.h"
+#include "../Graph/PhaseStats.h"
+#include "../Graph/ReachIndex.h"
+#include "../Graph/TAQuery.h"
+#include "Counter.h"
 
 using namespace std;
 
 TAGraph* ParentWalker::graph = new TAGraph();
-TAGraph* ParentWalker::currentGraph = nullptr;
 vector<TAGraph*> ParentWalker::graphList = vector<TAGraph*>();
+int ParentWalker::numThreads = 0;
+bool ParentWalker::lazyMode = false;
+bool ParentWalker::patching = false;
+ExceptionFlow* ParentWalker::queryFlow = nullptr;
+ReachIndex* ParentWalker::reachIndex = nullptr;
 vector<string> ParentWalker::headerExt = {"h","H","HPP","hpp","HXX","hxx","hh","HH","h++", "H++"};
 vector<string> ParentWalker::ext = {"C","c","CPP","cpp","CXX","cxx","cc","CC","c++", "C++"};
 
 std::string ParentWalker::CALLBACK_FLAG = "isCallbackFunc";
 
-std::string catchFlag = "caughtBy";
-
 
 static string replaceMap(string str){
   string s = str;
@@ -108,6 +116,10 @@ TAGraph* ParentWalker::getGraph(int num) {
  * Deletes all TA graphs being maintained.
  */
 void ParentWalker::deleteTAGraphs(){
+    delete queryFlow;
+    queryFlow = nullptr;
+    delete reachIndex;
+    reachIndex = nullptr;
     delete graph;
     for (int i = 0; i < graphList.size(); i++)
         delete graphList.at(i);
@@ -187,6 +199,8 @@ int ParentWalker::generateAllTAModels(vector<string> fileNames){
  * @return Whether the operation was successful.
  */
 bool ParentWalker::resolveAllTAModels(map<string, vector<string>> databaseMap){
+    PhaseStats::Timer timer("merge");
+
     //Goes through the graphs and forces them to resolve.
     for (TAGraph* curGraph : graphList){
         bool status  = curGraph->resolveComponents(databaseMap);
@@ -198,7 +212,9 @@ bool ParentWalker::resolveAllTAModels(map<string, vector<string>> databaseMap){
     }
     graphList.clear();
     graphList.emplace_back(newGraph);
+    timer.stop();
 
+    if (lazyMode) return true;
     cout << "Processing exceptions..." << endl;
     processExceptions();
     cout << "Done exceptions..." << endl;
@@ -369,6 +385,7 @@ bool ParentWalker::isInSystemHeader(const Decl *decl){
  * @return A string of the ID.
  */
 string ParentWalker::generateID(const NamedDecl* decl){
+    ZELDA_VISIT("ParentWalker::generateID(NamedDecl)");
     //Gets the canonical decl.
     decl = dyn_cast<NamedDecl>(decl->getCanonicalDecl());
     string name = "";
@@ -446,6 +463,7 @@ string ParentWalker::StmtID(const Stmt* stmt){
 }
 
 string ParentWalker::generateID(const Stmt* stmt){
+    ZELDA_VISIT("ParentWalker::generateID(Stmt)");
     const NamedDecl* decl = nullptr;
     string name; 
     // name try stmt function-tryNum
@@ -530,11 +548,7 @@ string ParentWalker::generateFileName(const NamedDecl* decl){
     if (!fullLoc.isValid()) return string();
 
     string fileName = SrcMgr.getFilename(fullLoc).str();
-
-    //Use boost to get the absolute path.
-    boost::filesystem::path fN = boost::filesystem::path(fileName);
-    string newPath = canonical(fN.normalize()).string();
-    return replaceMap(newPath);
+    return normalizeFileName(fileName);
 }
 
 string ParentWalker::generateFileName(const Stmt* stmt){
@@ -548,10 +562,39 @@ string ParentWalker::generateFileName(const Stmt* stmt){
     if (!fullLoc.isValid()) return string();
 
     string fileName = SrcMgr.getFilename(fullLoc).str();
+    return normalizeFileName(fileName);
+}
+
+/**
+ * Gets the filename of the main file of the translation unit.
+ * @return The filename of the unit being walked.
+ */
+string ParentWalker::generateUnitName(){
+    SourceManager& SrcMgr = Context->getSourceManager();
+    const FileEntry* entry = SrcMgr.getFileEntryForID(SrcMgr.getMainFileID());
+    if (!entry) return string();
+
+    string fileName(entry->getName());
+    return normalizeFileName(fileName);
+}
 
+/**
+ * Converts a path to the form files are recorded under. A file
+ * that no longer exists is resolved through its directory.
+ * @param fileName The path to convert.
+ * @return The normalized filename.
+ */
+string ParentWalker::normalizeFileName(string fileName){
     //Use boost to get the absolute path.
     boost::filesystem::path fN = boost::filesystem::path(fileName);
-    string newPath = canonical(fN.normalize()).string();
+    string newPath;
+    if (exists(fN)){
+        newPath = canonical(fN.normalize()).string();
+    } else if (exists(fN.parent_path())){
+        newPath = (canonical(fN.parent_path()) / fN.filename()).string();
+    } else {
+        newPath = fN.normalize().string();
+    }
     return replaceMap(newPath);
 }
 
@@ -575,6 +618,20 @@ void ParentWalker::recordParentClassLoc(const FunctionDecl* decl){
     parentClass->addMultiAttribute(FILENAME_ATTR, baseFN);
 }
 
+/**
+ * Records the class an exception type refers to, keyed by the
+ * canonical record declaration.
+ * @param node The throw or catch node.
+ * @param type The thrown or caught type.
+ */
+void ParentWalker::recordTypeClass(ZeldaNode* node, QualType type){
+    if (type.isNull()) return;
+    const CXXRecordDecl* record = type.getNonReferenceType()->getAsCXXRecordDecl();
+    if (!record) return;
+
+    node->addSingleAttribute(TYPE_CLASS_FLAG, generateID(record->getCanonicalDecl()));
+}
+
 /**
  * Validates a string argument.
  * @param name The argument to validate.
@@ -608,12 +665,16 @@ string ParentWalker::validateStringArg(string name){
  */
 int ParentWalker::generateTAModel(TAGraph* graph, string fileName){
     //Purge the edges.
+    PhaseStats::Timer purge("purgeUnestablishedEdges");
     graph->purgeUnestablishedEdges(true);
+    purge.stop();
 
     //Gets the string for the model.
+    PhaseStats::Timer write("TA writing");
     bool ret = graph->getTAModel(fileName);
+    write.stop();
 
-    return 0;
+    return (ret) ? 1 : 0;
 }
 
 /**
@@ -654,246 +715,278 @@ void ParentWalker::updateNodes(ZeldaNode* src, ZeldaNode* dest, const string& FL
 }
 
 void ParentWalker::processExceptions(){
-  // contains all throw nodes
+  PhaseStats::Timer timer("processExceptions");
+  //The last flow is kept so later queries reuse its summaries.
   for ( auto curGraph : graphList ){
-    currentGraph = curGraph;
-    vector<ZeldaNode*> throws = curGraph->findNodesByType(ZeldaNode::THROW);
-
-    // for each node determine where it is thrown to
-    for ( auto throwNode: throws ){
-      throwNode->addBoolAttribute("intermodual",false,true,false);
-      throwNode->addBoolAttribute("intermodualCatch",false,true,false);
-      vector<ZeldaEdge*> throwEdges = currentGraph->findEdgesByDst(throwNode->getName());
-
-      for ( int i = 0; i < throwEdges.size() ; ++i ){
-
-        ZeldaEdge* edge = throwEdges.at(i);
-        if ( ! edge )  continue;
-        ZeldaNode* contains = edge->getSource();
-        if ( ! contains ) continue;
-
-        ZeldaEdge* ret = nullptr;
-        vector<ZeldaEdge*> newThrows;
-
-        switch ( contains->getType() ){
-          case ZeldaNode::FUNCTION:
-            // throw is in a function
-            newThrows = processFunction(contains, throwNode);
-            for ( ZeldaEdge* rets : newThrows ){
-              throwEdges.emplace_back(rets);
-            }
-            continue;
-          case ZeldaNode::TRY:
-            // throw from a try block
-            ret = processTry(contains, throwNode, edge);
-            if ( ret && ret != edge ) {
-              throwEdges.emplace_back(ret);
-            }
-            continue;
-          case ZeldaNode::CATCH:
-            // throw from a catch block
-            ret = processCatch(contains, throwNode, edge);
-            if ( ret && ret != edge ){
-              throwEdges.emplace_back(ret);
-            }
-            continue;
-        }
-      }
-    }
+    delete queryFlow;
+    queryFlow = new ExceptionFlow(curGraph, numThreads);
+    queryFlow->run();
   }
-
 }
 
-vector<ZeldaEdge*> ParentWalker::processFunction(ZeldaNode* func, ZeldaNode* thrown){
-  // this function throws -> find all the calls to this function and add a throw edge
-  //     from thrown to the context of the call
-  if ( ! currentGraph->doesEdgeExist( func->getID(), thrown->getID(), ZeldaEdge::FUNC_THROWS ) ){
-        ZeldaEdge* newEdge = new ZeldaEdge( func, thrown, ZeldaEdge::FUNC_THROWS );
-        currentGraph->addEdge(newEdge);
-  }
-  vector<ZeldaEdge*> calls = currentGraph->findEdgesByTypeAndDst(func, ZeldaEdge::CONTEXT);
-  set<string> paths = thrown->getMultiAttribute("functions");
-  vector<ZeldaEdge*> rets;
-  string functionName = func->getName();
-
-  if ( paths.empty() ) { thrown->addSingleAttribute("function", functionName); }
-  if ( func->getBoolAttribute("isRecursive") ) return rets;
-
-  for ( auto context: paths ){
-    if ( context == functionName ){
-      func->addBoolAttribute("isRecursive", true); 
-      return rets;
-    }
+/**
+ * Writes how far every throw travels as CSV, along with a histogram of
+ * each metric. Nothing is written until exceptions have been propagated.
+ * @param metricsFile The file for one row per throw.
+ * @param histogramFile The file for the metric, value and count rows.
+ * @return Whether both files were written.
+ */
+bool ParentWalker::generateExceptionMetrics(string metricsFile, string histogramFile){
+  if ( !queryFlow ) return false;
+  vector<ExceptionFlow::ThrowMetrics> metrics = queryFlow->measure();
+  if ( metrics.empty() ) return false;
+
+  ofstream rows(metricsFile);
+  ofstream histogram(histogramFile);
+  if ( !rows.is_open() || !histogram.is_open() ) return false;
+
+  const vector<string> NAMES = {"frames", "functionHops", "functions", "handlers"};
+  vector<map<int, int>> counts(NAMES.size());
+  rows << "throw,frames,functionHops,functions,handlers,escapes,intermodual" << endl;
+  for ( auto& cur : metrics ){
+    rows << cur.throwNode->getID() << "," << cur.frames << "," << cur.functionHops << "," << cur.functions << ","
+         << cur.handlers << "," << cur.escapes << "," << cur.intermodual << "\n";
+    counts[0][cur.frames]++;
+    counts[1][cur.functionHops]++;
+    counts[2][cur.functions]++;
+    counts[3][cur.handlers]++;
   }
-  thrown->addMultiAttribute("functions", functionName );
-  thrown->addCountAttribute("funcCount", 1);
-  thrown->addMultiAttribute("path", functionName );
-  for ( auto edge: calls ){
-    ZeldaNode* callScope = edge->getSource();
-    if ( callScope ){
-      if ( ! currentGraph->doesEdgeExist( callScope->getID(), thrown->getID(), ZeldaEdge::THROWS ) ){
-        ZeldaEdge* newEdge = new ZeldaEdge( callScope, thrown, ZeldaEdge::THROWS );
-        currentGraph->addEdge(newEdge);
-        rets.emplace_back(newEdge);
-        string file1 = callScope->getSingleAttribute("filename"); 
-        string file2 = thrown->getSingleAttribute("filename");
-        // determine if catch and throw are in the same file
-        if ( ! file1.empty() && file1 != file2 && isCFile(file1) ) {
-          thrown->addBoolAttribute("intermodual",true);
-        } 
-      }
-    }
+
+  histogram << "metric,value,count" << endl;
+  for ( int i = 0; i < NAMES.size(); i++ ){
+    for ( auto& bucket : counts[i] ) histogram << NAMES[i] << "," << bucket.first << "," << bucket.second << "\n";
   }
+  return rows.good() && histogram.good();
+}
 
-  return rets;
-}
-
-ZeldaEdge* ParentWalker::processTry(ZeldaNode* tryNode, ZeldaNode* thrown, ZeldaEdge* edge){
-  vector<ZeldaEdge*> edges = currentGraph->findEdgesBySrc(tryNode->getName());
-  string thrownType = thrown->getSingleAttribute("type");
-  int numCatches = tryNode->getCountAttribute("countCatch");
-  vector<ZeldaEdge*> catches;
-  int foundCatch = 0;
-  // find catch edges in order
-  for ( auto it = edges.begin(); it != edges.end() && foundCatch < numCatches; ){
-    ZeldaEdge* edge = *it;
-    ZeldaNode* dest = edge->getDestination();
-    if ( !dest ){ ++it; continue; }
-    if ( edge->getType() == ZeldaEdge::CONTEXT && dest->getType() == ZeldaNode::CATCH 
-        && dest->getCountAttribute("order") == foundCatch ){
-          catches.emplace_back(edge);
-          it = edges.begin();
-          ++foundCatch;
-    } else {
-      ++it;
+/**
+ * Removes everything the translation units touching some files
+ * recorded, so those units can be walked again. Sources are always
+ * walked again; headers bring every unit that recorded facts from them.
+ * @param fileNames The normalized names of the changed files.
+ * @return The normalized names of the units to walk again.
+ */
+vector<string> ParentWalker::retractFiles(vector<string> fileNames){
+  if ( graphList.empty() ) return vector<string>();
+  TAGraph* resident = graphList.back();
+  delete reachIndex;
+  reachIndex = nullptr;
+
+  set<int> units;
+  for ( auto fileName : fileNames ){
+    int fileID = FileTable::find(fileName);
+    if ( fileID != FileTable::NO_FILE ){
+      for ( int unit : resident->findUnitsByFile(fileID) ) units.insert(unit);
     }
+    bool header = false;
+    for ( auto ext : headerExt ){
+      if ( boost::algorithm::ends_with(fileName, "." + ext) ) header = true;
+    }
+    if ( !header && isCFile(fileName) ) units.insert(FileTable::intern(fileName));
   }
 
-  // go through catches in order
-  // if the type matches catch type, change edge to catch
-  // otherwise check next edge
-  // if no edge match, exception is thrown to tryNodes's context
-
-  for ( auto it = catches.begin(); it != catches.end(); ++it ){
-    auto cEdge = *it;
-    ZeldaNode* catchNode = cEdge->getDestination();
-    if ( ! catchNode) continue;
-    if ( matchesType( thrown, catchNode )){
-
-      string file1 = catchNode->getSingleAttribute("filename"); 
-      string file2 = thrown->getSingleAttribute("filename");
-      // determine if catch and throw are in the same file
-      if ( ! file1.empty() && file1 != file2 && isCFile(file1) ) {
-        thrown->addBoolAttribute("intermodualCatch",true);
-        thrown->addBoolAttribute("intermodual",true);
-      }
- 
-      thrown->addMultiAttribute("caughtBy", catchNode->getName() );
-      return replaceEdge( edge, catchNode, thrown, ZeldaEdge::CATCHES );
-    } else {
-      thrown->addMultiAttribute("seenBy", catchNode->getName() );
-    } 
+  vector<string> names;
+  for ( int unit : units ){
+    resident->retractUnit(unit);
+    Counter::retractUnit(unit);
+    names.push_back(FileTable::getName(unit));
   }
-  
-  ZeldaNode* outerNode = currentGraph->findNodeByName(tryNode->getSingleAttribute("context"));
-  if ( outerNode == nullptr ){
-    return nullptr; 
-  }
-   
-  return replaceEdge( edge, outerNode, thrown, ZeldaEdge::THROWS );
-  
+  return names;
 }
 
-static void cleanType(string &s){
-  bool cont = true;
-  while ( cont ){
-    if ( s.length() > 6 && s.substr(0,6) == "const " ){
-      s = s.substr(6);
-    }
-    else if ( s.length() > 2 && s.substr(s.length()-2) == " &" ){
-      s = s.substr(0,s.length()-2);
-    }
-    else {
-      cont = false;
+/**
+ * Starts patching the resident graph. Units walked again go into a
+ * fresh graph that endPatch merges in, so the nodes other units link
+ * to are kept instead of being replaced by new copies.
+ */
+void ParentWalker::resumeGraph(){
+  if ( graphList.empty() ) return;
+  delete graph;
+  graph = new TAGraph();
+  patching = true;
+}
+
+/**
+ * Stops patching the resident graph, merges the new facts into it,
+ * links them to the rest of it and brings its exception flow up to date.
+ * @param units The normalized names of the units that were walked again.
+ */
+void ParentWalker::endPatch(vector<string> units){
+  if ( graphList.empty() || !patching ) return;
+  TAGraph* resident = graphList.back();
+  TAGraph* patch = graph;
+  graph = new TAGraph();
+  patching = false;
+
+  //Merging points the edges and links of other units at the new nodes.
+  resident->merge(patch);
+  delete patch;
+
+  resident->resolveUnestablishedEdges();
+  vector<ZeldaNode*> changed;
+  for ( auto unit : units ){
+    for ( auto node : resident->findNodesByUnit(FileTable::find(unit)) ){
+      if ( node->getType() == ZeldaNode::FUNCTION ) changed.push_back(node);
     }
   }
+  updateExceptions(changed);
 }
 
-bool ParentWalker::matchesType(ZeldaNode* thrown, ZeldaNode* match, bool subType){
-  string thrownType = thrown->getSingleAttribute("type");
-  string matchType  = match->getSingleAttribute("type");
-  if ( matchType == "all" ) return true;
+/**
+ * Recomputes exception flow after some functions changed, reusing the
+ * flow of the last full pass for everything the change cannot reach.
+ * @param changed The changed or added function nodes.
+ */
+void ParentWalker::updateExceptions(vector<ZeldaNode*> changed){
+  if ( !queryFlow ){
+    if ( !lazyMode ) processExceptions();
+    return;
+  }
+  queryFlow->update(changed);
+}
 
-  cleanType(thrownType);
-  cleanType(matchType);
+/**
+ * Sets the number of threads used to propagate exceptions.
+ * @param threads The thread count. Zero uses every core.
+ */
+void ParentWalker::setNumThreads(int threads){
+  numThreads = threads;
+}
 
-  if ( thrownType == matchType ){
-    return true;
-  }
-  if ( ! subType ) return false;
-  vector<ZeldaEdge*> subclasses = currentGraph->findEdgesByTypeAndSrc(match, ZeldaEdge::INHERITS );
-  
-  for ( auto edge: subclasses ){
-    ZeldaNode* subclass = edge->getDestination();
-    string subType = subclass->getSingleAttribute("type");
-    cleanType(subType);
-    if ( subType == thrownType ) return true;
-  }
-  
-  return false;
+/**
+ * Sets whether whole-program exception propagation is skipped.
+ * Exception flow is then only computed for queries.
+ * @param lazy Whether to skip the propagation pass.
+ */
+void ParentWalker::setLazyMode(bool lazy){
+  lazyMode = lazy;
+}
+
+/**
+ * Finds a query node by ID, falling back to its name.
+ * @param graph The graph to search.
+ * @param key The node ID or name.
+ * @return The node, or null.
+ */
+static ZeldaNode* findQueryNode(TAGraph* graph, const string& key){
+  ZeldaNode* node = graph->findNode(key);
+  if ( node ) return node;
+  return graph->findNodeByName(key);
+}
+
+/**
+ * Gets the exceptions that can escape a function. Results are computed
+ * on first use and kept for later queries.
+ * @param function The function ID or name.
+ * @return The throw nodes that can escape it.
+ */
+vector<ZeldaNode*> ParentWalker::queryEscapes(string function){
+  if ( graphList.empty() ) return vector<ZeldaNode*>();
+  if ( !queryFlow ) queryFlow = new ExceptionFlow(graphList.back(), numThreads);
+
+  ZeldaNode* node = findQueryNode(graphList.back(), function);
+  if ( !node || node->getType() != ZeldaNode::FUNCTION ) return vector<ZeldaNode*>();
+  return queryFlow->queryEscapes(node);
+}
+
+/**
+ * Gets the catches that handle a throw and the functions it escapes from.
+ * @param throwID The throw ID.
+ * @return The destination nodes.
+ */
+vector<ZeldaNode*> ParentWalker::queryDestinations(string throwID){
+  if ( graphList.empty() ) return vector<ZeldaNode*>();
+  if ( !queryFlow ) queryFlow = new ExceptionFlow(graphList.back(), numThreads);
+
+  ZeldaNode* node = findQueryNode(graphList.back(), throwID);
+  if ( !node || node->getType() != ZeldaNode::THROW ) return vector<ZeldaNode*>();
+  return queryFlow->queryDestinations(node);
 }
 
-ZeldaEdge* ParentWalker::replaceEdge(ZeldaEdge* oldEdge, ZeldaNode* newSrc, ZeldaNode* newDst, ZeldaEdge::EdgeType type){
-  if ( ! currentGraph->doesEdgeExist( newSrc->getID(), newDst->getID(), type )){
-    ZeldaEdge* newEdge = new ZeldaEdge( newSrc, newDst, type );
-    newDst->addMultiAttribute("path", oldEdge->getSource()->getName() );
-    oldEdge->setType(ZeldaEdge::THROWPATH);
-    //currentGraph->removeEdge(oldEdge->getSourceID(), oldEdge->getDestinationID(), oldEdge->getType(), true);
-    currentGraph->addEdge(newEdge);
-    return newEdge;
+/**
+ * Gets the route a throw takes to one of its destinations.
+ * @param throwID The throw ID.
+ * @param destination The ID or name of the catch or function.
+ * @return The throw, the scopes it passes through and the destination.
+ */
+vector<ZeldaNode*> ParentWalker::queryPath(string throwID, string destination){
+  if ( graphList.empty() ) return vector<ZeldaNode*>();
+  if ( !queryFlow ) queryFlow = new ExceptionFlow(graphList.back(), numThreads);
+
+  ZeldaNode* node = findQueryNode(graphList.back(), throwID);
+  ZeldaNode* target = findQueryNode(graphList.back(), destination);
+  if ( !node || !target || node->getType() != ZeldaNode::THROW ) return vector<ZeldaNode*>();
+  return queryFlow->queryPath(node, target);
+}
+
+/**
+ * Gets the edges of a node.
+ * @param key The node ID or name.
+ * @param edgeType The edge type as written in TA, or "all".
+ * @param outgoing Whether to follow edges out of the node instead of into it.
+ * @return The matching edges.
+ */
+vector<ZeldaEdge*> ParentWalker::queryNeighbors(string key, string edgeType, bool outgoing){
+  vector<ZeldaEdge*> result;
+  if ( graphList.empty() ) return result;
+
+  ZeldaNode* node = findQueryNode(graphList.back(), key);
+  if ( !node ) return result;
+  vector<ZeldaEdge*> edges = ( outgoing ) ? graphList.back()->findEdgesBySrc(node->getID())
+                                          : graphList.back()->findEdgesByDst(node->getID());
+  for ( auto edge : edges ){
+    if ( edgeType != "all" && ZeldaEdge::typeToString(edge->getType()) != edgeType ) continue;
+    result.push_back(edge);
   }
-  return nullptr;
+  return result;
 }
 
-ZeldaEdge* ParentWalker::processCatch(ZeldaNode* catchNode, ZeldaNode* thrown, ZeldaEdge* edge){
-  if ( edge->getType() == ZeldaEdge::CATCHES ) {
-    // either the catch doesn't throw, throws a different object, or rethrows
-    ZeldaNode* catchNode = edge->getSource();
-    if ( ! catchNode ) {
-      return nullptr;
-    }
-    string thrownType = thrown->getSingleAttribute("type");
-
-
-    vector<ZeldaEdge*> edges = currentGraph->findEdgesBySrc(catchNode->getID());
-    // find catch edges in order
-    for ( auto it = edges.begin(); it != edges.end() ; ++it ){
-      ZeldaEdge* edge = *it;
-      ZeldaNode* dest = edge->getDestination();
-      if ( !dest ) continue;
-      if ( edge->getType() == ZeldaEdge::RETHROWS && dest->getType() == ZeldaNode::RETHROW ){
-          // a throw is being rethrown -> can add an edge with the type thrown
-          ZeldaEdge* newEdge = new ZeldaEdge(catchNode, thrown, ZeldaEdge::THROWS);
-          currentGraph->addEdge(newEdge);
-          return newEdge;
-       }
-      }
-      thrown->addMultiAttribute("path", catchNode->getName() );
-      thrown->addMultiAttribute(catchFlag, catchNode->getName() );
-    
-  } 
-  // find outer stmt associated with this catch
-  else if ( edge->getType() == ZeldaEdge::THROWS ){
-    ZeldaNode* tryNode = currentGraph->findNodeByName(catchNode->getSingleAttribute("context"));
-      
-    ZeldaNode* outerNode = currentGraph->findNodeByName(tryNode->getSingleAttribute("context"));
-
-    if ( outerNode == nullptr ){
-
-      return nullptr; 
-    }
-    return replaceEdge( edge, outerNode, thrown, edge->getType() );
+/**
+ * Checks reachability between two nodes using the reachability index,
+ * which is built on first use and kept until the graph changes.
+ * @param from The starting node ID or name.
+ * @param to The node ID or name to reach, or a catch when checking exceptions.
+ * @param exception Whether to check if an exception from the start can arrive at the catch.
+ * @return 1 if reachable, 0 if not and -1 if either node is unknown.
+ */
+int ParentWalker::queryReach(string from, string to, bool exception){
+  if ( graphList.empty() ) return -1;
+  ZeldaNode* source = findQueryNode(graphList.back(), from);
+  ZeldaNode* target = findQueryNode(graphList.back(), to);
+  if ( !source || !target ) return -1;
+
+  if ( !reachIndex ) reachIndex = new ReachIndex(graphList.back());
+  bool reached = ( exception ) ? reachIndex->canExceptionReach(source, target) : reachIndex->canReach(source, target);
+  return ( reached ) ? 1 : 0;
+}
+
+/**
+ * Evaluates a relational query against the merged graph.
+ * @param expression The query, as described in TAQuery.h.
+ * @param result Receives the source and destination IDs.
+ * @param error Receives a message if the query is invalid.
+ * @return Whether the query was evaluated.
+ */
+bool ParentWalker::queryRelation(string expression, vector<pair<string, string>>& result, string& error){
+  if ( graphList.empty() ){
+    error = "no graph has been built";
+    return false;
   }
-  return nullptr;
+
+  TAQuery query(graphList.back());
+  TAQuery::Relation relation;
+  if ( !query.evaluate(expression, relation, error) ) return false;
+  result = TAQuery::toIDs(relation);
+  return true;
 }
 
+/**
+ * Estimates the memory held by the merged graph.
+ * @param report Receives the breakdown.
+ * @return Whether a graph has been built.
+ */
+bool ParentWalker::reportMemory(MemoryReport& report){
+  if ( graphList.empty() ) return false;
+  report = graphList.back()->memoryReport();
+  return true;
+}
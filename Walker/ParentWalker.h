@@ -38,9 +38,12 @@
 #include "clang/Tooling/CommonOptionsParser.h"
 #include "llvm/Support/CommandLine.h"
 #include "../Graph/TAGraph.h"
+#include "../Graph/VisitStats.h"
 
 class ZeldaWalker;
 class MinimalZeldaWalker;
+class ExceptionFlow;
+class ReachIndex;
 
 using namespace llvm;
 using namespace clang;
@@ -69,6 +72,21 @@ public:
 //    static bool dumpCurrentFile(int fileNum, std::string fileName);
 //    static bool dumpCurrentSettings(std::vector<bs::path> files, bool minMode);
     static void processExceptions();
+    static bool generateExceptionMetrics(std::string metricsFile, std::string histogramFile);
+    static void updateExceptions(std::vector<ZeldaNode*> changed);
+    static std::vector<std::string> retractFiles(std::vector<std::string> fileNames);
+    static void resumeGraph();
+    static void endPatch(std::vector<std::string> units);
+    static std::string normalizeFileName(std::string fileName);
+    static void setNumThreads(int threads);
+    static void setLazyMode(bool lazy);
+    static std::vector<ZeldaNode*> queryEscapes(std::string function);
+    static std::vector<ZeldaNode*> queryDestinations(std::string throwID);
+    static std::vector<ZeldaNode*> queryPath(std::string throwID, std::string destination);
+    static std::vector<ZeldaEdge*> queryNeighbors(std::string key, std::string edgeType, bool outgoing);
+    static int queryReach(std::string from, std::string to, bool exception);
+    static bool queryRelation(std::string expression, std::vector<std::pair<std::string, std::string>>& result, std::string& error);
+    static bool reportMemory(MemoryReport& report);
     static bool isCFile(std::string str);
 
     //Processing Operations
@@ -84,11 +102,17 @@ protected:
     const std::string CONTEXT_FLAG = "context";
     const std::string TYPE_FLAG = "type";
     const std::string PARAM_FLAG = "isParam";
+    const std::string TYPE_CLASS_FLAG = "typeClass";
     
     const std::string FILENAME_ATTR = "filename";
 
     static TAGraph* graph;
     static std::vector<TAGraph*> graphList;
+    static int numThreads;
+    static bool lazyMode;
+    static bool patching;
+    static ExceptionFlow* queryFlow;
+    static ReachIndex* reachIndex;
     ASTContext *Context;
 
 
@@ -108,7 +132,9 @@ protected:
     std::string validateStringArg(std::string name);
     std::string generateFileName(const NamedDecl* decl);
     std::string generateFileName(const Stmt* stmt);
+    std::string generateUnitName();
     void recordParentClassLoc(const FunctionDecl* decl);
+    void recordTypeClass(ZeldaNode* node, QualType type);
     static std::string StmtID(const Stmt*);
 
 private:
@@ -133,14 +159,6 @@ private:
     std::vector<std::string> getArgs(const CallExpr* expr);
     NamedDecl* getParentVariable(const Expr* callExpr);
 
-    static std::vector<ZeldaEdge*> processFunction(ZeldaNode* func, ZeldaNode* thrown); 
-    static ZeldaEdge* processTry(ZeldaNode* tryNode, ZeldaNode* thrown, ZeldaEdge* edge); 
-    static ZeldaEdge* processCatch(ZeldaNode* catchNode, ZeldaNode* thrown, ZeldaEdge* edge); 
-    static bool matchesType(ZeldaNode* thrown, ZeldaNode* match, bool subType = true);
-    static ZeldaEdge* replaceEdge(ZeldaEdge* oldEdge, ZeldaNode* newSrc, ZeldaNode* newDst, ZeldaEdge::EdgeType type);
-
-    static TAGraph* currentGraph;  
-
 };
 
 
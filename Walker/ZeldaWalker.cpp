@@ -35,6 +35,8 @@
 #include <boost/algorithm/string/predicate.hpp>
 #include <sstream>
 #include "../Graph/ZeldaNode.h"
+#include "../Graph/ExceptionFlow.h"
+#include "../Graph/FileTable.h"
 
 using namespace std;
 
@@ -53,18 +55,21 @@ ZeldaWalker::~ZeldaWalker(){ }
 
 
 bool ZeldaWalker::VisitStmt(Stmt *statement) {
+    ZELDA_VISIT("ZeldaWalker::VisitStmt");
     if (isInSystemHeader(statement) && !checkLibrary ) return true;
 
     return true;
 }
 
 bool ZeldaWalker::VisitCallExpr(CallExpr* expr){
+    ZELDA_VISIT("ZeldaWalker::VisitCallExpr");
     if (isInSystemHeader(expr) && !checkLibrary ) return true;
     recordCallExpr(expr);
     return true;
 }
 
 bool ZeldaWalker::VisitCXXConstructExpr(CXXConstructExpr* expr){
+  ZELDA_VISIT("ZeldaWalker::VisitCXXConstructExpr");
   if (isInSystemHeader(expr) && !checkLibrary ) return true;
   recordCXXConstructExpr(expr);
 
@@ -72,6 +77,7 @@ bool ZeldaWalker::VisitCXXConstructExpr(CXXConstructExpr* expr){
 }
 
 bool ZeldaWalker::VisitCXXTryStmt(CXXTryStmt* stmt){
+  ZELDA_VISIT("ZeldaWalker::VisitCXXTryStmt");
   // add to TA graph -> link to function
   if ( isInSystemHeader(stmt) ) return true;
    
@@ -82,6 +88,7 @@ bool ZeldaWalker::VisitCXXTryStmt(CXXTryStmt* stmt){
 }
 
 bool ZeldaWalker::VisitCXXCatchStmt(CXXCatchStmt* stmt){
+  ZELDA_VISIT("ZeldaWalker::VisitCXXCatchStmt");
   // add to TA graph -> link to function
   if (isInSystemHeader(stmt) ) return true;
    
@@ -92,6 +99,7 @@ bool ZeldaWalker::VisitCXXCatchStmt(CXXCatchStmt* stmt){
 }
 
 bool ZeldaWalker::VisitCXXThrowExpr(CXXThrowExpr* expr){
+  ZELDA_VISIT("ZeldaWalker::VisitCXXThrowExpr");
   if (isInSystemHeader(expr) ) return true;
   
   if ( isInSystemHeader(expr) ){
@@ -110,6 +118,7 @@ bool ZeldaWalker::VisitCXXThrowExpr(CXXThrowExpr* expr){
 
 
 bool ZeldaWalker::VisitFunctionDecl(FunctionDecl* decl){
+    ZELDA_VISIT("ZeldaWalker::VisitFunctionDecl");
     if (isInSystemHeader(decl) && !checkLibrary ) return true;
 
     bool system = isInSystemHeader(decl);
@@ -124,6 +133,7 @@ bool ZeldaWalker::VisitFunctionDecl(FunctionDecl* decl){
 }
 
 bool ZeldaWalker::VisitCXXRecordDecl(CXXRecordDecl* decl){
+    ZELDA_VISIT("ZeldaWalker::VisitCXXRecordDecl");
     if (isInSystemHeader(decl) && !checkLibrary ) return true;
 
       recordClassDecl(decl);
@@ -131,6 +141,25 @@ bool ZeldaWalker::VisitCXXRecordDecl(CXXRecordDecl* decl){
     return true;
 }
 
+/**
+ * Walks a translation unit and then resolves the throws that are
+ * caught inside their own function before the next unit starts.
+ * Everything recorded meanwhile is stamped with the unit. This only
+ * happens while ExceptConsumer runs this walker, which it does not yet.
+ * @param decl The translation unit.
+ * @return Whether the traversal completed.
+ */
+bool ZeldaWalker::TraverseTranslationUnitDecl(TranslationUnitDecl* decl){
+    ZELDA_VISIT("ZeldaWalker::TraverseTranslationUnitDecl");
+    unitThrows.clear();
+    graph->setCurrentUnit(FileTable::intern(generateUnitName()));
+    bool result = RecursiveASTVisitor<ZeldaWalker>::TraverseTranslationUnitDecl(decl);
+
+    ExceptionFlow::resolveLocal(graph, unitThrows);
+    graph->setCurrentUnit(FileTable::NO_FILE);
+    unitThrows.clear();
+    return result;
+}
 
 /**
  * Records a basic function declaration to the TA model.
@@ -157,6 +186,7 @@ void ZeldaWalker::recordFunctionDecl(const FunctionDecl* decl, bool system){
     string filename = generateFileName(decl);
     if ( isCFile(filename) )
       node->addSingleAttribute(FILENAME_ATTR, filename);
+    node->setFileID(FileTable::intern(filename));
     
     auto exceptInfo = decl->getExceptionSpecSourceRange(); 
 
@@ -180,6 +210,7 @@ void ZeldaWalker::recordCXXTryStmt(const CXXTryStmt* stmt){
     node->addCountAttribute(COUNT_TRY_FLAG);
     node->addCountAttribute(COUNT_THROW_FLAG);
     node->addCountAttribute(COUNT_CATCH_FLAG);
+    node->setFileID(FileTable::intern(generateFileName(stmt)));
     graph->addNode(node);
     
     //Get the parent.
@@ -202,10 +233,12 @@ void ZeldaWalker::recordCXXCatchStmt(const CXXCatchStmt* stmt){
     string catchType = stmt->getCaughtType().getAsString();
     updateType(catchType);
     node->addSingleAttribute(TYPE_FLAG, catchType);
+    recordTypeClass(node, stmt->getCaughtType());
     //Resolves the filename.
     string filename = generateFileName(stmt);
     if ( isCFile(filename) )
       node->addSingleAttribute(FILENAME_ATTR, filename);
+    node->setFileID(FileTable::intern(filename));
     graph->addNode(node);
     
     //Get the parent.
@@ -231,12 +264,15 @@ void ZeldaWalker::recordCXXThrowExpr(const CXXThrowExpr* expr){
 
     ZeldaNode* node = new ZeldaNode(ID, ID, type);
     node->addSingleAttribute(TYPE_FLAG, throwType);
+    if ( subExpr ) recordTypeClass(node, subExpr->getType());
     node->addSingleAttribute("function", "");
     //Resolves the filename.
     string filename = generateFileName(expr);
     if ( isCFile(filename) )
       node->addSingleAttribute(FILENAME_ATTR, filename);
+    node->setFileID(FileTable::intern(filename));
     graph->addNode(node);
+    unitThrows.push_back(node);
     
     //Get the parent.
     addParentRelationship(expr, ID);
@@ -250,10 +286,11 @@ void ZeldaWalker::recordClassDecl(const CXXRecordDecl *decl) {
     //Creates the node.
     if (!graph->doesNodeExist(ID)) {
         ZeldaNode *node = new ZeldaNode(ID, name, ZeldaNode::CLASS);
-        graph->addNode(node);
         //Resolves the filename.
         string filename = generateFileName(decl);
         node->addMultiAttribute(FILENAME_ATTR, filename);
+        node->setFileID(FileTable::intern(filename));
+        graph->addNode(node);
     }
     
     addBaseClasses(decl);
@@ -270,15 +307,13 @@ void ZeldaWalker::addBaseClasses(const CXXRecordDecl* decl){
     if ( node == nullptr ) return;
 
     for ( auto& base: decl->bases() ){
-      string baseName = base.getType().getAsString();
-  
-      // clean class name for future matching
-      if ( baseName.substr(0, 7) == "struct ") baseName = baseName.substr(7);
-      if ( baseName.substr(0, 6) == "class ") baseName = baseName.substr(6);
-      
-      ZeldaNode* baseNode = graph->findNode(baseName);
-      if ( baseNode == nullptr ) continue;
-      string baseID = baseNode->getID();  
+      // dependent bases have no record until instantiation
+      const CXXRecordDecl* baseDecl = base.getType()->getAsCXXRecordDecl();
+      if ( baseDecl == nullptr ) continue;
+
+      // bases are keyed by their canonical declaration, like the class nodes
+      string baseID = generateID(baseDecl->getCanonicalDecl());
+      ZeldaNode* baseNode = graph->findNode(baseID);
       
       if (graph->doesEdgeExist(baseID, ID, ZeldaEdge::INHERITS)){
 
@@ -293,6 +328,7 @@ void ZeldaWalker::addBaseClasses(const CXXRecordDecl* decl){
 
 
 bool ZeldaWalker::VisitCXXMemberCallExpr(CXXMemberCallExpr* expr){
+    ZELDA_VISIT("ZeldaWalker::VisitCXXMemberCallExpr");
     if (isInSystemHeader(expr) && !checkLibrary ) return true;
     recordCXXMemberCallExpr(expr);
     return true;
@@ -731,10 +767,39 @@ void ZeldaWalker::updateNode(ZeldaNode* src, ZeldaNode* dst, const Stmt* stmt, Z
   }
 
   if ( type == ZeldaEdge::CONTEXT && dst && dst->getType() != ZeldaNode::FUNCTION ) dst->addSingleAttribute(CONTEXT_FLAG, src->getName());
+  if ( dst ) linkNode(src, dst, type);
 
   graph->addEdge(new ZeldaEdge(src, dst, type));
 }
 
+/**
+ * Records the direct structural links between a scope and the try,
+ * catch or throw it contains, so propagation can follow pointers
+ * instead of looking nodes up by name.
+ * @param src The enclosing scope.
+ * @param dst The contained node.
+ * @param type The edge type between them.
+ */
+void ZeldaWalker::linkNode(ZeldaNode* src, ZeldaNode* dst, ZeldaEdge::EdgeType type){
+  switch ( dst->getType() ){
+    case ZeldaNode::TRY:
+      if ( type == ZeldaEdge::CONTEXT ) dst->setScope(src);
+      break;
+    case ZeldaNode::CATCH:
+      if ( type != ZeldaEdge::CONTEXT || src->getType() != ZeldaNode::TRY ) break;
+      dst->setScope(src);
+      dst->setOwner(src);
+      src->addHandler(dst);
+      break;
+    case ZeldaNode::THROW:
+    case ZeldaNode::RETHROW:
+      if ( type == ZeldaEdge::THROWS || type == ZeldaEdge::RETHROWS ) dst->setScope(src);
+      break;
+    default:
+      break;
+  }
+}
+
 
 const FunctionDecl* ZeldaWalker::getParentFunction(const Stmt* baseFunc){
     bool getParent = true;
@@ -59,9 +59,12 @@ public:
     bool VisitCXXTryStmt(CXXTryStmt* stmt);
     bool VisitCXXCatchStmt(CXXCatchStmt* stmt);
     bool VisitCXXThrowExpr(CXXThrowExpr* expr);
+    bool TraverseTranslationUnitDecl(TranslationUnitDecl* decl);
 
 private:
 
+    std::vector<ZeldaNode*> unitThrows;
+
     std::vector<clang::Expr*> parentExpression;
 
     //C++ Detectors
@@ -94,6 +97,7 @@ private:
     ZeldaNode* handleParent(const NamedDecl* parent);
     ZeldaNode* handleParent(const Stmt* parent);
     void updateNode(ZeldaNode* src, ZeldaNode* dst, const Stmt* stmt, ZeldaEdge::EdgeType type);
+    void linkNode(ZeldaNode* src, ZeldaNode* dst, ZeldaEdge::EdgeType type);
     std::string walkerID(const Stmt* stmt);
 };
 